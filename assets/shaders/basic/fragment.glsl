@@ -2,12 +2,27 @@
 
 precision mediump float;
 
+#ifndef ALPHA_CUTOFF
+#define ALPHA_CUTOFF 0.5
+#endif
+
 out vec4 outColor;
 
 in vec2 texCoord;
+#ifdef HAS_VERTEX_COLORS
+in vec4 vertexColor;
+#endif
 
 uniform sampler2D u_texture;
 
 void main() {
     outColor = texture(u_texture, texCoord);
+#ifdef HAS_VERTEX_COLORS
+    outColor *= vertexColor;
+#endif
+#ifdef ALPHA_MASK
+    if (outColor.a < ALPHA_CUTOFF) {
+        discard;
+    }
+#endif
 }
\ No newline at end of file
@@ -1,11 +1,17 @@
 #version 460 core
 
-layout(location=0) in vec3 a_position;
-layout(location=1) in vec2 a_texcoord;
+#include "../common/attributes.glsl"
+#include "../common/object.glsl"
 
 out vec2 texCoord;
+#ifdef HAS_VERTEX_COLORS
+out vec4 vertexColor;
+#endif
 
 void main() {
-    gl_Position = vec4(a_position, 1.0);
+    gl_Position = u_model * vec4(a_position, 1.0);
     texCoord = a_texcoord;
+#ifdef HAS_VERTEX_COLORS
+    vertexColor = a_color;
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,8 @@
+#pragma once
+
+// Vertex inputs at the locations of Core::GLTF::attributeLocations
+layout(location=0) in vec3 a_position;
+layout(location=1) in vec2 a_texcoord;
+#ifdef HAS_VERTEX_COLORS
+layout(location=4) in vec4 a_color;
+#endif
\ No newline at end of file
@@ -0,0 +1,6 @@
+#pragma once
+
+// Per-draw data written by Core::GL::RenderQueue, the transform comes first
+layout(std140, binding=2) uniform ObjectData {
+    mat4 u_model;
+};
\ No newline at end of file
@@ -0,0 +1,18 @@
+#version 460 core
+
+#include "../common/attributes.glsl"
+
+out vec2 texCoord;
+
+struct DrawData {
+    mat4 transform;
+};
+
+layout(std430, binding=0) readonly buffer DrawBuffer {
+    DrawData draws[];
+};
+
+void main() {
+    gl_Position = draws[gl_DrawID].transform * vec4(a_position, 1.0);
+    texCoord = a_texcoord;
+}
\ No newline at end of file
@@ -0,0 +1,246 @@
+#include "Base64.hpp"
+
+#include <array>
+#include <cstdint>
+
+// The SSSE3 and AVX2 paths are compiled for those targets whatever the
+// build flags and picked from the CPU at runtime
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define CORE_BASE64_X86 1
+#endif
+
+namespace
+{
+    constexpr uint8_t invalid = 0xFF;
+
+    constexpr std::array<uint8_t, 256> decodeTable = []
+    {
+        std::array<uint8_t, 256> table{};
+        table.fill(invalid);
+        constexpr std::string_view alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        for (size_t i = 0; i < alphabet.size(); ++i)
+        {
+            table[static_cast<unsigned char>(alphabet[i])] = static_cast<uint8_t>(i);
+        }
+        return table;
+    }();
+
+    std::string_view stripPadding(std::string_view text) noexcept
+    {
+        if (text.size() % 4 == 0)
+        {
+            for (int i = 0; i < 2 && !text.empty() && text.back() == '='; ++i)
+            {
+                text.remove_suffix(1);
+            }
+        }
+        return text;
+    }
+
+    uint8_t lookup(char c) noexcept
+    {
+        return decodeTable[static_cast<unsigned char>(c)];
+    }
+
+    // Decodes whole groups of four characters and then the final two or
+    // three. Padding has already been stripped.
+    bool decodeScalar(const char *in, size_t length, std::byte *out) noexcept
+    {
+        size_t i = 0;
+        for (; i + 4 <= length; i += 4)
+        {
+            uint32_t a = lookup(in[i]), b = lookup(in[i + 1]), c = lookup(in[i + 2]), d = lookup(in[i + 3]);
+            // Valid values fit in six bits, so any invalid one sets bit 7
+            if ((a | b | c | d) & 0x80)
+            {
+                return false;
+            }
+            uint32_t bits = a << 18 | b << 12 | c << 6 | d;
+            *out++ = static_cast<std::byte>(bits >> 16);
+            *out++ = static_cast<std::byte>(bits >> 8);
+            *out++ = static_cast<std::byte>(bits);
+        }
+
+        size_t rest = length - i;
+        if (rest >= 2)
+        {
+            uint32_t a = lookup(in[i]), b = lookup(in[i + 1]), c = rest == 3 ? lookup(in[i + 2]) : 0;
+            if ((a | b | c) & 0x80)
+            {
+                return false;
+            }
+            uint32_t bits = a << 18 | b << 12 | c << 6;
+            *out++ = static_cast<std::byte>(bits >> 16);
+            if (rest == 3)
+            {
+                *out++ = static_cast<std::byte>(bits >> 8);
+            }
+        }
+        return true;
+    }
+
+    // Character classification and packing after Wojciech Muła's pshufb
+    // decoder. The low and high nibble of every character each select a set
+    // of bits; a character is in the alphabet when the two sets do not
+    // overlap. The high nibble then picks the offset from ASCII to the
+    // 6-bit value, with '/' moved to a slot of its own, and two multiply-add
+    // steps pack four 6-bit values into three bytes per 32-bit lane.
+#if defined(CORE_BASE64_X86)
+    // Decodes 16 characters into 12 bytes, but stores 16
+    __attribute__((target("ssse3"))) bool decode16(const char *in, std::byte *out) noexcept
+    {
+        const __m128i lowSets = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                              0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+        const __m128i highSets = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                               0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+        const __m128i offsets = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+        const __m128i slash = _mm_set1_epi8(0x2F);
+
+        __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+        __m128i high = _mm_and_si128(_mm_srli_epi32(chars, 4), slash);
+        __m128i low = _mm_and_si128(chars, slash);
+        __m128i overlap = _mm_and_si128(_mm_shuffle_epi8(lowSets, low), _mm_shuffle_epi8(highSets, high));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(overlap, _mm_setzero_si128())) != 0xFFFF)
+        {
+            return false;
+        }
+
+        __m128i isSlash = _mm_cmpeq_epi8(chars, slash);
+        __m128i values = _mm_add_epi8(chars, _mm_shuffle_epi8(offsets, _mm_add_epi8(isSlash, high)));
+        __m128i pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+        __m128i packed = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+        packed = _mm_shuffle_epi8(packed, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), packed);
+        return true;
+    }
+
+    // Decodes 32 characters into 24 bytes, but stores 32
+    __attribute__((target("avx2"))) bool decode32(const char *in, std::byte *out) noexcept
+    {
+        const __m256i lowSets = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                                 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+                                                 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                                 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+        const __m256i highSets = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                                  0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                                  0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                                  0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+        const __m256i offsets = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+                                                 0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+        const __m256i slash = _mm256_set1_epi8(0x2F);
+
+        __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in));
+        __m256i high = _mm256_and_si256(_mm256_srli_epi32(chars, 4), slash);
+        __m256i low = _mm256_and_si256(chars, slash);
+        __m256i overlap = _mm256_and_si256(_mm256_shuffle_epi8(lowSets, low), _mm256_shuffle_epi8(highSets, high));
+        if (!_mm256_testz_si256(overlap, overlap))
+        {
+            return false;
+        }
+
+        __m256i isSlash = _mm256_cmpeq_epi8(chars, slash);
+        __m256i values = _mm256_add_epi8(chars, _mm256_shuffle_epi8(offsets, _mm256_add_epi8(isSlash, high)));
+        __m256i pairs = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+        __m256i packed = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+        // Twelve bytes at the bottom of each 128-bit lane, then the lanes joined
+        packed = _mm256_shuffle_epi8(packed, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                                              2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        packed = _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), packed);
+        return true;
+    }
+
+    // The vector steps store a few bytes past what they decode, so they
+    // stop while there is still room for a full store. Both advance in and
+    // out past what they decoded and leave the rest to decodeScalar.
+    __attribute__((target("ssse3"))) bool decodeSsse3(const char *&in, const char *inEnd, std::byte *&out, std::byte *outEnd) noexcept
+    {
+        for (; inEnd - in >= 16 && outEnd - out >= 16; in += 16, out += 12)
+        {
+            if (!decode16(in, out))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    __attribute__((target("avx2"))) bool decodeAvx2(const char *&in, const char *inEnd, std::byte *&out, std::byte *outEnd) noexcept
+    {
+        for (; inEnd - in >= 32 && outEnd - out >= 32; in += 32, out += 24)
+        {
+            if (!decode32(in, out))
+            {
+                return false;
+            }
+        }
+        return decodeSsse3(in, inEnd, out, outEnd);
+    }
+
+    enum class Level
+    {
+        Scalar,
+        Ssse3,
+        Avx2
+    };
+
+    Level detectLevel() noexcept
+    {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return Level::Avx2;
+        }
+        return __builtin_cpu_supports("ssse3") ? Level::Ssse3 : Level::Scalar;
+    }
+#endif
+}
+
+std::optional<size_t> Core::base64DecodedSize(std::string_view text) noexcept
+{
+    text = stripPadding(text);
+    if (text.size() % 4 == 1)
+    {
+        return std::nullopt;
+    }
+    return text.size() / 4 * 3 + (text.size() % 4 == 0 ? 0 : text.size() % 4 - 1);
+}
+
+bool Core::decodeBase64(std::string_view text, std::span<std::byte> out) noexcept
+{
+    auto size = base64DecodedSize(text);
+    if (!size || *size != out.size())
+    {
+        return false;
+    }
+    text = stripPadding(text);
+
+    const char *in = text.data();
+    const char *inEnd = in + text.size();
+    std::byte *o = out.data();
+#if defined(CORE_BASE64_X86)
+    static const Level level = detectLevel();
+    std::byte *outEnd = o + out.size();
+    if (level == Level::Avx2 && !decodeAvx2(in, inEnd, o, outEnd))
+    {
+        return false;
+    }
+    if (level == Level::Ssse3 && !decodeSsse3(in, inEnd, o, outEnd))
+    {
+        return false;
+    }
+#endif
+    return decodeScalar(in, static_cast<size_t>(inEnd - in), o);
+}
+
+bool Core::decodeBase64Scalar(std::string_view text, std::span<std::byte> out) noexcept
+{
+    auto size = base64DecodedSize(text);
+    if (!size || *size != out.size())
+    {
+        return false;
+    }
+    text = stripPadding(text);
+    return decodeScalar(text.data(), text.size(), out.data());
+}
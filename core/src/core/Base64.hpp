@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace Core
+{
+    // Size of the data in standard base64 text (RFC 4648, '=' padding
+    // optional), or nothing if no valid encoding has that length
+    [[nodiscard]] std::optional<size_t> base64DecodedSize(std::string_view text) noexcept;
+
+    // Decodes base64 text straight into out, which must be exactly
+    // base64DecodedSize(text) bytes. Returns false on characters outside
+    // the alphabet, including whitespace. Runs 32 or 16 characters per step
+    // on x86 CPUs with AVX2 or SSSE3, a table lookup per character otherwise.
+    [[nodiscard]] bool decodeBase64(std::string_view text, std::span<std::byte> out) noexcept;
+
+    // The table lookup path alone, as a reference for decodeBase64
+    [[nodiscard]] bool decodeBase64Scalar(std::string_view text, std::span<std::byte> out) noexcept;
+}
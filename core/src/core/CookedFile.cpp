@@ -0,0 +1,250 @@
+#include "CookedFile.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <utility>
+
+#include "Hash.hpp"
+#include "Trace.hpp"
+
+namespace
+{
+    // Bumped when the header or section table layout changes
+    constexpr uint32_t containerVersion = 1;
+
+    // Source paths, NUL separated, in a section of their own
+    constexpr uint32_t sourcesSection = 0xFFFFFFFFu;
+
+    // Large enough that the per-chunk jobs are cheap next to hashing them
+    constexpr size_t hashChunkSize = 4 * 1024 * 1024;
+
+    size_t alignUp(size_t value) noexcept
+    {
+        return (value + Core::CookedFile::alignment - 1) / Core::CookedFile::alignment * Core::CookedFile::alignment;
+    }
+}
+
+Core::CookedFile::Writer::Writer(uint32_t formatMagic, uint32_t version, std::vector<std::string> sourcePaths)
+    : magic(formatMagic), formatVersion(version), sources(std::move(sourcePaths))
+{
+}
+
+std::optional<std::string> Core::CookedFile::Writer::write(const std::string &path, JobSystem &jobs) const
+{
+    CORE_TRACE_ZONE("CookedFile::write");
+    auto sourceHash = hashFiles(sources, jobs);
+    if (!sourceHash)
+    {
+        return "Cannot hash the sources of " + path;
+    }
+
+    std::string sourceList;
+    for (const auto &source : sources)
+    {
+        sourceList += source;
+        sourceList += '\0';
+    }
+    std::vector<Entry> all = entries;
+    all.push_back({sourcesSection, 1, std::as_bytes(std::span(sourceList))});
+
+    std::vector<Section> table;
+    size_t offset = alignUp(sizeof(Header) + all.size() * sizeof(Section));
+    for (const auto &entry : all)
+    {
+        table.push_back({entry.id, entry.elementSize, offset, entry.data.size() / entry.elementSize});
+        offset = alignUp(offset + entry.data.size());
+    }
+
+    Header header{};
+    header.magic = magic;
+    header.formatVersion = formatVersion;
+    header.containerVersion = containerVersion;
+    header.sectionCount = static_cast<uint32_t>(table.size());
+    header.sourceHash = *sourceHash;
+    header.fileSize = offset;
+
+    std::error_code error;
+    auto parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty())
+    {
+        std::filesystem::create_directories(parent, error);
+    }
+
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        const char padding[alignment] = {};
+        auto pad = [&](size_t written)
+        { file.write(padding, static_cast<std::streamsize>(alignUp(written) - written)); };
+
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(table.data()), static_cast<std::streamsize>(table.size() * sizeof(Section)));
+        pad(sizeof(Header) + table.size() * sizeof(Section));
+        for (const auto &entry : all)
+        {
+            file.write(reinterpret_cast<const char *>(entry.data.data()), static_cast<std::streamsize>(entry.data.size()));
+            pad(entry.data.size());
+        }
+        if (!file)
+        {
+            file.close();
+            std::filesystem::remove(tempPath, error);
+            return "Failed to write cooked file: " + tempPath;
+        }
+    }
+
+    std::filesystem::rename(tempPath, path, error);
+    if (error)
+    {
+        std::filesystem::remove(tempPath, error);
+        return "Failed to replace cooked file: " + path;
+    }
+    return std::nullopt;
+}
+
+Core::CookedFile::CookedFile(CookedFile &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+Core::CookedFile &Core::CookedFile::operator=(CookedFile &&other) noexcept
+{
+    if (this != &other)
+    {
+        // The mapping moves with the file, so the views stay valid
+        file = std::move(other.file);
+        header = std::exchange(other.header, nullptr);
+        sections = std::exchange(other.sections, {});
+    }
+    return *this;
+}
+
+std::optional<std::string> Core::CookedFile::open(const std::string &path, uint32_t formatMagic, uint32_t version)
+{
+    header = nullptr;
+    sections = {};
+    if (auto error = file.open(path); error)
+    {
+        return error;
+    }
+
+    auto data = file.getData();
+    if (data.size() < sizeof(Header))
+    {
+        file.close();
+        return "Cooked file is truncated: " + path;
+    }
+    const auto *candidate = reinterpret_cast<const Header *>(data.data());
+    if (candidate->magic != formatMagic || candidate->containerVersion != containerVersion)
+    {
+        file.close();
+        return "Not a cooked file of the expected format: " + path;
+    }
+    if (candidate->formatVersion != version)
+    {
+        file.close();
+        return "Cooked file is from another format version: " + path;
+    }
+    // A size mismatch means a write was cut short or the file was edited
+    if (candidate->fileSize != data.size() || sizeof(Header) + size_t(candidate->sectionCount) * sizeof(Section) > data.size())
+    {
+        file.close();
+        return "Cooked file is truncated: " + path;
+    }
+
+    std::span<const Section> table(reinterpret_cast<const Section *>(data.data() + sizeof(Header)), candidate->sectionCount);
+    for (const auto &section : table)
+    {
+        bool fits = section.elementSize != 0 && section.offset % alignment == 0 && section.offset <= data.size() &&
+                    section.count <= (data.size() - section.offset) / section.elementSize;
+        if (!fits)
+        {
+            file.close();
+            return "Cooked file has a section outside the file: " + path;
+        }
+    }
+
+    header = candidate;
+    sections = table;
+    return std::nullopt;
+}
+
+bool Core::CookedFile::isCurrent(JobSystem &jobs) const
+{
+    if (!header)
+    {
+        return false;
+    }
+    auto paths = getSourcePaths();
+    auto hash = hashFiles(paths, jobs);
+    return hash && *hash == header->sourceHash;
+}
+
+std::vector<std::string> Core::CookedFile::getSourcePaths() const
+{
+    std::vector<std::string> paths;
+    auto list = findSection(sourcesSection, 1);
+    std::string_view text(reinterpret_cast<const char *>(list.data()), list.size());
+    while (!text.empty())
+    {
+        size_t end = std::min(text.find('\0'), text.size());
+        paths.emplace_back(text.substr(0, end));
+        text.remove_prefix(std::min(end + 1, text.size()));
+    }
+    return paths;
+}
+
+bool Core::CookedFile::hasSection(uint32_t id) const noexcept
+{
+    return std::any_of(sections.begin(), sections.end(), [&](const Section &section)
+                       { return section.id == id; });
+}
+
+std::span<const std::byte> Core::CookedFile::findSection(uint32_t id, size_t elementSize) const noexcept
+{
+    for (const auto &section : sections)
+    {
+        if (section.id == id)
+        {
+            if (section.elementSize != elementSize)
+            {
+                return {};
+            }
+            return file.getData().subspan(section.offset, section.count * section.elementSize);
+        }
+    }
+    return {};
+}
+
+std::optional<uint64_t> Core::hashFiles(std::span<const std::string> paths, JobSystem &jobs)
+{
+    CORE_TRACE_ZONE("hashFiles");
+    uint64_t hash = fnvOffsetBasis;
+    for (const auto &path : paths)
+    {
+        MappedFile file;
+        if (file.open(path))
+        {
+            return std::nullopt;
+        }
+
+        // Chunks are hashed on their own across the pool, then the chunk
+        // hashes in order
+        auto data = file.getData();
+        std::vector<uint64_t> chunkHashes((data.size() + hashChunkSize - 1) / hashChunkSize);
+        jobs.parallelFor(chunkHashes.size(), 1, [&](size_t begin, size_t end)
+                         {
+            for (size_t i = begin; i < end; ++i)
+            {
+                size_t offset = i * hashChunkSize;
+                chunkHashes[i] = xxh64(data.subspan(offset, std::min(hashChunkSize, data.size() - offset)));
+            } });
+
+        uint64_t size = data.size();
+        hash = fnv1a(std::as_bytes(std::span(&size, 1)), hash);
+        hash = fnv1a(std::as_bytes(std::span(chunkHashes)), hash);
+    }
+    return hash;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "JobSystem.hpp"
+#include "MappedFile.hpp"
+
+namespace Core
+{
+    // Versioned binary container for data converted ahead of time from a
+    // slower source format. A 64-byte header and a section table are
+    // followed by the section blobs, each starting on a 64-byte boundary,
+    // so a mapped file is viewed as typed arrays in place and handed to the
+    // GL without parsing or copying. The header records the paths and a
+    // content hash of the files the data was cooked from; readers rehash
+    // them to detect stale files. Data is stored in the writer's byte order
+    // and struct layout: this is a local cache, not a distribution format.
+    class CookedFile
+    {
+    public:
+        static constexpr size_t alignment = 64;
+
+        struct Header
+        {
+            uint32_t magic;
+            uint32_t formatVersion;
+            uint32_t containerVersion;
+            uint32_t sectionCount;
+            uint64_t sourceHash;
+            uint64_t fileSize;
+            uint8_t reserved[32];
+        };
+        static_assert(sizeof(Header) == alignment);
+
+        struct Section
+        {
+            uint32_t id;
+            uint32_t elementSize;
+            uint64_t offset;
+            uint64_t count;
+        };
+
+        // Collects sections and writes them out in one go. Sections are
+        // views, their data must stay alive until write() returns.
+        class Writer
+        {
+        private:
+            struct Entry
+            {
+                uint32_t id;
+                uint32_t elementSize;
+                std::span<const std::byte> data;
+            };
+
+            uint32_t magic;
+            uint32_t formatVersion;
+            std::vector<std::string> sources;
+            std::vector<Entry> entries;
+
+        public:
+            Writer(uint32_t formatMagic, uint32_t version, std::vector<std::string> sourcePaths);
+
+            template <typename T>
+            void addSection(uint32_t id, std::span<const T> data)
+            {
+                entries.push_back({id, static_cast<uint32_t>(sizeof(T)), std::as_bytes(data)});
+            }
+
+            // Hashes the sources, then writes to a temporary file renamed
+            // over path, so a concurrent reader never sees a partial file
+            std::optional<std::string> write(const std::string &path, JobSystem &jobs = JobSystem::shared()) const;
+        };
+
+    private:
+        MappedFile file;
+        const Header *header = nullptr;
+        std::span<const Section> sections;
+
+    public:
+        CookedFile() = default;
+
+        // The following prevents copying, but allows moving
+        CookedFile(const CookedFile &) = delete;
+        CookedFile &operator=(const CookedFile &) = delete;
+        CookedFile(CookedFile &&other) noexcept;
+        CookedFile &operator=(CookedFile &&other) noexcept;
+
+        // Maps path and checks it is a complete file of the given format and
+        // version whose sections all lie inside it. Does not look at the
+        // sources, see isCurrent().
+        std::optional<std::string> open(const std::string &path, uint32_t formatMagic, uint32_t version);
+
+        // Whether every source file still has the content it was cooked from
+        [[nodiscard]] bool isCurrent(JobSystem &jobs = JobSystem::shared()) const;
+
+        [[nodiscard]] std::vector<std::string> getSourcePaths() const;
+
+        // The section viewed as T, empty when it is missing or was written
+        // with elements of another size
+        template <typename T>
+        [[nodiscard]] std::span<const T> getSection(uint32_t id) const noexcept
+        {
+            auto bytes = findSection(id, sizeof(T));
+            return {reinterpret_cast<const T *>(bytes.data()), bytes.size() / sizeof(T)};
+        }
+
+        [[nodiscard]] bool hasSection(uint32_t id) const noexcept;
+        [[nodiscard]] bool isOpen() const noexcept { return header != nullptr; }
+
+    private:
+        std::span<const std::byte> findSection(uint32_t id, size_t elementSize) const noexcept;
+    };
+
+    // Content hash of a list of files, each mapped and hashed in chunks
+    // across the job system. Nothing if any of them cannot be opened.
+    [[nodiscard]] std::optional<uint64_t> hashFiles(std::span<const std::string> paths, JobSystem &jobs = JobSystem::shared());
+}
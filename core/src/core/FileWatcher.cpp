@@ -0,0 +1,164 @@
+#include "FileWatcher.hpp"
+
+#include <algorithm>
+#include <filesystem>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    std::string normalise(const std::filesystem::path &path)
+    {
+        return path.lexically_normal().generic_string();
+    }
+}
+
+#ifdef __linux__
+
+Core::FileWatcher::FileWatcher()
+    : descriptor(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+{
+}
+
+Core::FileWatcher::~FileWatcher()
+{
+    if (descriptor >= 0)
+    {
+        ::close(descriptor);
+    }
+}
+
+std::optional<std::string> Core::FileWatcher::watchDirectory(const std::string &directory)
+{
+    if (descriptor < 0)
+    {
+        return "inotify is unavailable";
+    }
+
+    std::string path = normalise(directory);
+    if (isWatching(path))
+    {
+        return std::nullopt;
+    }
+
+    int watch = inotify_add_watch(descriptor, path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (watch < 0)
+    {
+        return "Failed to watch " + path + ": " + std::strerror(errno);
+    }
+    directories[watch] = path;
+    return std::nullopt;
+}
+
+bool Core::FileWatcher::isWatching(const std::string &directory) const
+{
+    std::string path = normalise(directory);
+    return std::any_of(directories.begin(), directories.end(), [&](const auto &entry)
+                       { return entry.second == path; });
+}
+
+std::vector<std::string> Core::FileWatcher::poll()
+{
+    std::vector<std::string> changed;
+    if (descriptor < 0)
+    {
+        return changed;
+    }
+
+    alignas(inotify_event) char buffer[4096];
+    while (true)
+    {
+        ssize_t length = ::read(descriptor, buffer, sizeof(buffer));
+        if (length <= 0)
+        {
+            // EAGAIN once the queue is drained
+            break;
+        }
+
+        for (char *cursor = buffer; cursor < buffer + length;)
+        {
+            auto *event = reinterpret_cast<inotify_event *>(cursor);
+            cursor += sizeof(inotify_event) + event->len;
+
+            auto directory = directories.find(event->wd);
+            if (directory == directories.end() || event->len == 0 || (event->mask & IN_ISDIR))
+            {
+                continue;
+            }
+            std::string path = normalise(std::filesystem::path(directory->second) / event->name);
+            if (std::find(changed.begin(), changed.end(), path) == changed.end())
+            {
+                changed.push_back(std::move(path));
+            }
+        }
+    }
+    return changed;
+}
+
+#else
+
+Core::FileWatcher::FileWatcher() = default;
+
+Core::FileWatcher::~FileWatcher() = default;
+
+std::optional<std::string> Core::FileWatcher::watchDirectory(const std::string &directory)
+{
+    std::string path = normalise(directory);
+    if (isWatching(path))
+    {
+        return std::nullopt;
+    }
+
+    std::error_code error;
+    Directory watched;
+    for (const auto &entry : std::filesystem::directory_iterator(path, error))
+    {
+        if (entry.is_regular_file(error))
+        {
+            watched.times[normalise(entry.path())] = entry.last_write_time(error);
+        }
+    }
+    if (error)
+    {
+        return "Failed to watch " + path + ": " + error.message();
+    }
+    directories.emplace(std::move(path), std::move(watched));
+    return std::nullopt;
+}
+
+bool Core::FileWatcher::isWatching(const std::string &directory) const
+{
+    return directories.contains(normalise(directory));
+}
+
+std::vector<std::string> Core::FileWatcher::poll()
+{
+    std::vector<std::string> changed;
+    for (auto &[path, directory] : directories)
+    {
+        std::error_code error;
+        for (const auto &entry : std::filesystem::directory_iterator(path, error))
+        {
+            if (!entry.is_regular_file(error))
+            {
+                continue;
+            }
+            std::string file = normalise(entry.path());
+            auto time = entry.last_write_time(error);
+            auto [known, inserted] = directory.times.try_emplace(file, time);
+            if (inserted || known->second != time)
+            {
+                known->second = time;
+                changed.push_back(std::move(file));
+            }
+        }
+    }
+    return changed;
+}
+
+#endif
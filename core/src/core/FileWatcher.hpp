@@ -0,0 +1,52 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#ifndef __linux__
+#include <filesystem>
+#endif
+
+namespace Core
+{
+    // Reports files written in a set of watched directories. Directories
+    // are watched rather than files because editors often save by writing
+    // a new file and renaming it over the old one. On Linux this is
+    // inotify (a file counts as changed once closed after writing or moved
+    // into place) and checking costs one non-blocking read; elsewhere
+    // modification times are compared on every poll.
+    class FileWatcher
+    {
+    private:
+#ifdef __linux__
+        int descriptor = -1;
+        // Watch descriptor to directory
+        std::unordered_map<int, std::string> directories;
+#else
+        struct Directory
+        {
+            std::unordered_map<std::string, std::filesystem::file_time_type> times;
+        };
+        std::unordered_map<std::string, Directory> directories;
+#endif
+
+    public:
+        FileWatcher();
+        ~FileWatcher();
+
+        // The following prevents copying and moving, the watches belong to
+        // this object
+        FileWatcher(const FileWatcher &) = delete;
+        FileWatcher &operator=(const FileWatcher &) = delete;
+
+        // Watching a directory twice is harmless
+        std::optional<std::string> watchDirectory(const std::string &directory);
+
+        [[nodiscard]] bool isWatching(const std::string &directory) const;
+
+        // Normalised paths of files changed since the last call, each once
+        [[nodiscard]] std::vector<std::string> poll();
+    };
+}
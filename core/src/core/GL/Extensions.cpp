@@ -0,0 +1,41 @@
+#include "Extensions.hpp"
+
+#include <string_view>
+
+namespace
+{
+    Core::GL::Extensions supported;
+}
+
+void Core::GL::loadExtensions(ProcLoader loader)
+{
+    supported = {};
+
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i)
+    {
+        std::string_view name = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, static_cast<GLuint>(i)));
+        if (name == "GL_KHR_parallel_shader_compile" && !supported.maxShaderCompilerThreads)
+        {
+            supported.maxShaderCompilerThreads = reinterpret_cast<Extensions::MaxShaderCompilerThreadsProc>(loader("glMaxShaderCompilerThreadsKHR"));
+        }
+        else if (name == "GL_ARB_parallel_shader_compile" && !supported.maxShaderCompilerThreads)
+        {
+            supported.maxShaderCompilerThreads = reinterpret_cast<Extensions::MaxShaderCompilerThreadsProc>(loader("glMaxShaderCompilerThreadsARB"));
+        }
+    }
+    supported.parallelShaderCompile = supported.maxShaderCompilerThreads != nullptr;
+
+    // Let the driver use as many compiler threads as it likes; the KHR
+    // default may be a single thread
+    if (supported.parallelShaderCompile)
+    {
+        supported.maxShaderCompilerThreads(0xFFFFFFFFu);
+    }
+}
+
+const Core::GL::Extensions &Core::GL::extensions() noexcept
+{
+    return supported;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// The bundled glad only covers core OpenGL 4.6, extension tokens and entry
+// points core uses are declared here
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+namespace Core::GL
+{
+    using ProcLoader = void *(*)(const char *name);
+
+    struct Extensions
+    {
+        using MaxShaderCompilerThreadsProc = void(APIENTRYP)(GLuint count);
+
+        // GL_KHR_parallel_shader_compile, or the ARB original. Without it,
+        // GL_COMPLETION_STATUS_KHR must not be queried.
+        bool parallelShaderCompile = false;
+        MaxShaderCompilerThreadsProc maxShaderCompilerThreads = nullptr;
+    };
+
+    // Called by Window once glad is loaded, with the same loader. Extension
+    // support is looked up once; core assumes a single context.
+    void loadExtensions(ProcLoader loader);
+
+    [[nodiscard]] const Extensions &extensions() noexcept;
+}
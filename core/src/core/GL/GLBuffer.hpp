@@ -5,6 +5,9 @@
 #include <span>
 #include <memory>
 #include <optional>
+#include <string>
+
+#include "GLState.hpp"
 
 namespace Core::GL
 {
@@ -12,9 +15,14 @@ namespace Core::GL
     {
         Vertex = GL_ARRAY_BUFFER,
         Index = GL_ELEMENT_ARRAY_BUFFER,
-        Uniform = GL_UNIFORM_BUFFER
+        Uniform = GL_UNIFORM_BUFFER,
+        PixelUnpack = GL_PIXEL_UNPACK_BUFFER,
+        DrawIndirect = GL_DRAW_INDIRECT_BUFFER,
+        ShaderStorage = GL_SHADER_STORAGE_BUFFER
     };
 
+    // Immutable buffer storage edited through direct state access, so
+    // creating and filling buffers never touches the current bindings.
     class GLBuffer
     {
     private:
@@ -27,11 +35,12 @@ namespace Core::GL
             : type(static_cast<GLenum>(bufferType)),
               bufferId(new GLuint(0), [](GLuint *id)
                        { if (id && *id) {
+                GLState::current().onBufferDeleted(*id);
                 glDeleteBuffers(1, id);
                 delete id;
               } })
         {
-            glGenBuffers(1, bufferId.get());
+            glCreateBuffers(1, bufferId.get());
         }
 
         // The following prevents copying, but allows moving
@@ -42,42 +51,38 @@ namespace Core::GL
 
         ~GLBuffer() = default;
 
-        void bind() const noexcept
+        void bind() const
         {
-            glBindBuffer(type, *bufferId);
+            GLState::current().bindBuffer(type, *bufferId);
         }
 
-        void unbind() const noexcept
+        void unbind() const
         {
-            glBindBuffer(type, 0);
+            GLState::current().bindBuffer(type, 0);
         }
 
+        // Storage is immutable: calling this again on a filled buffer
+        // replaces it with a new buffer object, so attach it to vertex arrays
+        // after uploading. updateData needs GL_DYNAMIC_STORAGE_BIT.
         template <typename T>
-        std::optional<std::string> setData(std::span<T> data, GLenum usage = GL_STATIC_DRAW)
+        std::optional<std::string> setData(std::span<T> data, GLbitfield flags = GL_DYNAMIC_STORAGE_BIT)
         {
-            if (data.empty())
-            {
-                return "Invalid buffer data";
-            }
-
-            size = data.size_bytes();
-            bind();
-            glBufferData(type, size, data.data(), usage);
-            unbind();
-
-            return std::nullopt;
+            return setData(data.size_bytes(), data.data(), flags);
         }
 
-        std::optional<std::string> setData(size_t dataSize, const void *data, GLenum usage = GL_STATIC_DRAW)
+        std::optional<std::string> setData(size_t dataSize, const void *data, GLbitfield flags = GL_DYNAMIC_STORAGE_BIT)
         {
             if (!data || dataSize == 0)
             {
                 return "Invalid buffer data";
             }
+            if (size != 0)
+            {
+                recreate();
+            }
             size = dataSize;
-            bind();
-            glBufferData(type, size, data, usage);
-            unbind();
+            glNamedBufferStorage(*bufferId, static_cast<GLsizeiptr>(size), data, flags);
+            GLState::current().onUpload(size);
 
             return std::nullopt;
         }
@@ -89,13 +94,20 @@ namespace Core::GL
                 return "Buffer update out of bounds";
             }
 
-            bind();
-            glBufferSubData(type, offset, data.size_bytes(), data.data());
-            unbind();
+            glNamedBufferSubData(*bufferId, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(data.size_bytes()), data.data());
+            GLState::current().onUpload(data.size_bytes());
             return std::nullopt;
         }
 
         [[nodiscard]] GLuint getID() const noexcept { return *bufferId; }
         [[nodiscard]] size_t getSize() const noexcept { return size; }
+
+    private:
+        void recreate()
+        {
+            GLState::current().onBufferDeleted(*bufferId);
+            glDeleteBuffers(1, bufferId.get());
+            glCreateBuffers(1, bufferId.get());
+        }
     };
-}
\ No newline at end of file
+}
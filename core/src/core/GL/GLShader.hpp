@@ -1,20 +1,69 @@
 #pragma once
 
 #include <glad/glad.h>
+#include <algorithm>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_map>
+#include <utility>
 #include <iostream>
-#include <fstream>
-#include <sstream>
+#include <memory>
 #include <optional>
+#include <span>
+#include <thread>
 #include <glm/glm.hpp>
 
+#include "../Hash.hpp"
+#include "../Trace.hpp"
+#include "Extensions.hpp"
+#include "GLState.hpp"
 #include "GLTexture.hpp"
+#include "ShaderCache.hpp"
+#include "ShaderPreprocessor.hpp"
 
 namespace Core::GL
 {
 
+    // A uniform name hashed at compile time, so naming a uniform costs
+    // nothing at the call site: setUniform("u_model", ...)
+    struct UniformId
+    {
+        uint64_t hash;
+        std::string_view name;
+
+        consteval UniformId(const char *literal)
+            : hash(fnv1a(literal)), name(literal)
+        {
+        }
+
+        // For names only known at run time
+        explicit constexpr UniformId(std::string_view runtimeName)
+            : hash(fnv1a(runtimeName)), name(runtimeName)
+        {
+        }
+    };
+
+    // A uniform resolved against one shader. Setting it through the handle
+    // is a single array index; the default handle refers to no uniform and
+    // setting it does nothing.
+    struct UniformHandle
+    {
+        uint32_t index = 0;
+
+        [[nodiscard]] bool isValid() const noexcept { return index != 0; }
+    };
+
+    enum class CompileMode
+    {
+        // Compile and link before the constructor returns
+        Immediate,
+        // Only issue the compile and link, the driver may work on many
+        // programs at once (GL_KHR_parallel_shader_compile). Results are
+        // checked and the program reflected by finish().
+        Deferred
+    };
+
     class GLShader
     {
     public:
@@ -35,10 +84,36 @@ namespace Core::GL
 
         struct UniformBlock
         {
+            // Byte layout of one block member as the linker laid it out.
+            // Strides are 0 for non-arrays and non-matrices.
+            struct Member
+            {
+                std::string name;
+                uint64_t hash;
+                GLenum type;
+                GLint offset;
+                GLint arrayStride;
+                GLint matrixStride;
+                GLint size;
+            };
+
             std::string name;
             GLuint index;
             GLint size;
             GLint binding;
+            std::vector<Member> members;
+
+            [[nodiscard]] const Member *findMember(UniformId id) const noexcept
+            {
+                for (const Member &member : members)
+                {
+                    if (member.hash == id.hash)
+                    {
+                        return &member;
+                    }
+                }
+                return nullptr;
+            }
         };
 
     private:
@@ -46,33 +121,190 @@ namespace Core::GL
         std::vector<Attribute> attributes;
         std::vector<Uniform> uniforms;
         std::vector<UniformBlock> uniformBlocks;
-        std::unordered_map<std::string, GLint> uniformCache;
+        // Indexed by UniformHandle, the first slot is the invalid handle
+        std::vector<GLint> handleLocations{-1};
+        // Name hash to handle index, sorted by hash
+        std::vector<std::pair<uint64_t, uint32_t>> uniformLookup;
+
+        // Left to check while a deferred compile is in flight
+        bool pending = false;
+        GLuint vertexShader = 0;
+        GLuint fragmentShader = 0;
+        const ShaderCache *pendingCache = nullptr;
+        std::optional<uint64_t> pendingCacheKey;
+        // Source string numbers to paths, for compiler messages
+        std::vector<std::string> vertexFiles;
+        std::vector<std::string> fragmentFiles;
+
+        // Kept to build the program again when a source changes
+        std::string vertexSourcePath;
+        std::string fragmentSourcePath;
+        std::string sourceDefines;
+        const ShaderCache *shaderCache;
+        bool linked = false;
+        uint32_t revision = 0;
 
     public:
-        GLShader(const std::string &vertexPath, const std::string &fragmentPath)
-            : programID(0)
+        // With a cache, a previously linked binary for the same sources is
+        // loaded instead of compiling
+        GLShader(const std::string &vertexPath, const std::string &fragmentPath, const ShaderCache *cache = nullptr, CompileMode mode = CompileMode::Immediate)
+            : GLShader(vertexPath, fragmentPath, std::string_view(), cache, mode)
         {
-            if (auto error = compileShader(vertexPath, fragmentPath); error)
+        }
+
+        // Sources go through ShaderPreprocessor::shared(), so they may
+        // #include other files. Defines are lines such as
+        // "#define HAS_NORMAL_MAP\n", inserted into both stages right after
+        // #version.
+        GLShader(const std::string &vertexPath, const std::string &fragmentPath, std::string_view defines, const ShaderCache *cache = nullptr, CompileMode mode = CompileMode::Immediate)
+            : programID(0),
+              vertexSourcePath(vertexPath),
+              fragmentSourcePath(fragmentPath),
+              sourceDefines(defines),
+              shaderCache(cache)
+        {
+            if (auto error = compileShader(vertexPath, fragmentPath, defines, cache); error)
             {
                 std::cerr << "Shader Compilation Error: " << *error << '\n';
             }
-            else
+            else if (mode == CompileMode::Immediate)
             {
-                reflectShader();
+                finish();
             }
         }
 
         ~GLShader()
         {
+            deleteShaders();
             if (programID)
             {
+                GLState::current().onProgramDeleted(programID);
                 glDeleteProgram(programID);
             }
         }
 
+        // Without parallel compile support there is nothing to poll and
+        // this is always true, finish() then waits for the driver
+        [[nodiscard]] bool isReady() const
+        {
+            if (!pending || !extensions().parallelShaderCompile)
+            {
+                return true;
+            }
+            GLint complete = GL_FALSE;
+            glGetProgramiv(programID, GL_COMPLETION_STATUS_KHR, &complete);
+            return complete == GL_TRUE;
+        }
+
+        // Checks the results of a deferred compile and reflects the program,
+        // waiting for the driver if it is not done yet. Does nothing for a
+        // finished shader. Reflection, handles and blocks are only there
+        // after this.
+        void finish()
+        {
+            if (!pending)
+            {
+                return;
+            }
+            pending = false;
+            if (auto error = checkProgram(); error)
+            {
+                std::cerr << "Shader Compilation Error: " << *error << '\n';
+                return;
+            }
+            reflectShader();
+            linked = true;
+        }
+
+        // Finishes deferred shaders in the order the driver completes them,
+        // so the results of one are handled while others still compile
+        static void finishAll(std::span<GLShader *const> shaders)
+        {
+            std::vector<GLShader *> remaining(shaders.begin(), shaders.end());
+            while (!remaining.empty())
+            {
+                auto done = std::partition(remaining.begin(), remaining.end(), [](GLShader *shader)
+                                           { return !shader->isReady(); });
+                if (done == remaining.end())
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                for (auto it = done; it != remaining.end(); ++it)
+                {
+                    (*it)->finish();
+                }
+                remaining.erase(done, remaining.end());
+            }
+        }
+
+        [[nodiscard]] bool isPending() const noexcept { return pending; }
+        // Finished without compile or link errors
+        [[nodiscard]] bool isLinked() const noexcept { return linked; }
+
+        // Whether path, normalised as ShaderPreprocessor does, went into
+        // either stage, includes counted
+        [[nodiscard]] bool dependsOn(const std::string &path) const
+        {
+            return std::find(vertexFiles.begin(), vertexFiles.end(), path) != vertexFiles.end() ||
+                   std::find(fragmentFiles.begin(), fragmentFiles.end(), path) != fragmentFiles.end();
+        }
+
+        [[nodiscard]] std::vector<std::string> getSourceFiles() const
+        {
+            std::vector<std::string> files = vertexFiles;
+            for (const auto &file : fragmentFiles)
+            {
+                if (std::find(files.begin(), files.end(), file) == files.end())
+                {
+                    files.push_back(file);
+                }
+            }
+            return files;
+        }
+
+        // Starts a deferred build of the same sources and defines, read
+        // again through the preprocessor. This shader is left untouched.
+        [[nodiscard]] std::unique_ptr<GLShader> recompile() const
+        {
+            return std::make_unique<GLShader>(vertexSourcePath, fragmentSourcePath, sourceDefines, shaderCache, CompileMode::Deferred);
+        }
+
+        // Exchanges programs, reflection and everything else with another
+        // shader, so code holding this object picks up a rebuilt program.
+        // Handles resolved against this shader before keep naming the same
+        // uniforms, and become invalid for uniforms the new program lacks.
+        // The revision changes on every swap so holders can tell.
+        void swap(GLShader &other)
+        {
+            std::swap(programID, other.programID);
+            std::swap(attributes, other.attributes);
+            std::swap(uniforms, other.uniforms);
+            std::swap(uniformBlocks, other.uniformBlocks);
+            std::swap(handleLocations, other.handleLocations);
+            std::swap(uniformLookup, other.uniformLookup);
+            std::swap(pending, other.pending);
+            std::swap(vertexShader, other.vertexShader);
+            std::swap(fragmentShader, other.fragmentShader);
+            std::swap(pendingCache, other.pendingCache);
+            std::swap(pendingCacheKey, other.pendingCacheKey);
+            std::swap(vertexFiles, other.vertexFiles);
+            std::swap(fragmentFiles, other.fragmentFiles);
+            std::swap(vertexSourcePath, other.vertexSourcePath);
+            std::swap(fragmentSourcePath, other.fragmentSourcePath);
+            std::swap(sourceDefines, other.sourceDefines);
+            std::swap(shaderCache, other.shaderCache);
+            std::swap(linked, other.linked);
+            keepHandles(other.handleLocations.size(), other.uniformLookup);
+            ++revision;
+            ++other.revision;
+        }
+
+        [[nodiscard]] uint32_t getRevision() const noexcept { return revision; }
+
         void use() const
         {
-            glUseProgram(programID);
+            GLState::current().useProgram(programID);
         }
 
         GLuint getID() const { return programID; }
@@ -81,36 +313,176 @@ namespace Core::GL
         const std::vector<Uniform> &getUniforms() const { return uniforms; }
         const std::vector<UniformBlock> &getUniformBlocks() const { return uniformBlocks; }
 
-        void setUniform(const std::string &name, int value) { glUniform1i(getUniformLocation(name), value); }
-        void setUniform(const std::string &name, float value) { glUniform1f(getUniformLocation(name), value); }
-        void setUniform(const std::string &name, const glm::vec2 &value) { glUniform2fv(getUniformLocation(name), 1, &value[0]); }
-        void setUniform(const std::string &name, const glm::vec3 &value) { glUniform3fv(getUniformLocation(name), 1, &value[0]); }
-        void setUniform(const std::string &name, const glm::vec4 &value) { glUniform4fv(getUniformLocation(name), 1, &value[0]); }
-        void setUniform(const std::string &name, const glm::mat4 &value) { glUniformMatrix4fv(getUniformLocation(name), 1, GL_FALSE, &value[0][0]); }
+        // Resolve once, outside the draw loop. Returns the invalid handle
+        // with a warning when the shader has no such active uniform.
+        [[nodiscard]] UniformHandle getHandle(UniformId id) const
+        {
+            auto it = std::lower_bound(uniformLookup.begin(), uniformLookup.end(), id.hash, [](const auto &entry, uint64_t hash)
+                                       { return entry.first < hash; });
+            if (it == uniformLookup.end() || it->first != id.hash)
+            {
+                std::cerr << "Warning: Uniform '" << id.name << "' not found in shader\n";
+                return {};
+            }
+            return {it->second};
+        }
+
+        // -1 for the invalid handle and for handles from another shader
+        [[nodiscard]] GLint getLocation(UniformHandle handle) const noexcept
+        {
+            return handle.index < handleLocations.size() ? handleLocations[handle.index] : -1;
+        }
+
+        // Blocks are found by their block name, not their instance name
+        [[nodiscard]] const UniformBlock *findBlock(UniformId id) const noexcept
+        {
+            for (const UniformBlock &block : uniformBlocks)
+            {
+                if (fnv1a(block.name) == id.hash)
+                {
+                    return &block;
+                }
+            }
+            return nullptr;
+        }
+
+        // For blocks declared without layout(binding = ...)
+        void setBlockBinding(UniformId id, GLuint binding)
+        {
+            for (UniformBlock &block : uniformBlocks)
+            {
+                if (fnv1a(block.name) == id.hash)
+                {
+                    glUniformBlockBinding(programID, block.index, binding);
+                    block.binding = static_cast<GLint>(binding);
+                    return;
+                }
+            }
+            std::cerr << "Warning: Uniform block '" << id.name << "' not found in shader\n";
+        }
+
+        void setUniform(UniformHandle handle, int value) const { glUniform1i(getLocation(handle), value); }
+        void setUniform(UniformHandle handle, float value) const { glUniform1f(getLocation(handle), value); }
+        void setUniform(UniformHandle handle, const glm::vec2 &value) const { glUniform2fv(getLocation(handle), 1, &value[0]); }
+        void setUniform(UniformHandle handle, const glm::vec3 &value) const { glUniform3fv(getLocation(handle), 1, &value[0]); }
+        void setUniform(UniformHandle handle, const glm::vec4 &value) const { glUniform4fv(getLocation(handle), 1, &value[0]); }
+        void setUniform(UniformHandle handle, const glm::mat4 &value) const { glUniformMatrix4fv(getLocation(handle), 1, GL_FALSE, &value[0][0]); }
+
+        // Looks the id up on every call, prefer handles for per-draw updates
+        template <typename T>
+        void setUniform(UniformId id, const T &value) const
+        {
+            setUniform(getHandle(id), value);
+        }
 
-        void setTexture(const std::string &name, const GLTexture &texture, GLuint unit)
+        void setTexture(UniformHandle handle, const GLTexture &texture, GLuint unit) const
         {
-            glUniform1i(getUniformLocation(name), unit);
+            glUniform1i(getLocation(handle), static_cast<GLint>(unit));
             texture.bind(unit);
         }
 
+        void setTexture(UniformId id, const GLTexture &texture, GLuint unit) const
+        {
+            setTexture(getHandle(id), texture, unit);
+        }
+
     private:
-        std::optional<std::string> compileShader(const std::string &vertexPath, const std::string &fragmentPath)
+        // Renumbers the handles of a freshly swapped in program so the
+        // indices of the previous one keep their uniforms, by name hash.
+        // Uniforms the previous program did not have get the slots after.
+        void keepHandles(size_t previousCount, const std::vector<std::pair<uint64_t, uint32_t>> &previousLookup)
+        {
+            std::vector<GLint> locations(std::max<size_t>(previousCount, 1), -1);
+            std::vector<uint32_t> renumbered(handleLocations.size(), 0);
+            for (const auto &[hash, previous] : previousLookup)
+            {
+                auto it = std::lower_bound(uniformLookup.begin(), uniformLookup.end(), hash, [](const auto &entry, uint64_t key)
+                                           { return entry.first < key; });
+                if (it != uniformLookup.end() && it->first == hash && renumbered[it->second] == 0)
+                {
+                    renumbered[it->second] = previous;
+                    locations[previous] = handleLocations[it->second];
+                }
+            }
+            for (uint32_t handle = 1; handle < handleLocations.size(); ++handle)
+            {
+                if (renumbered[handle] == 0)
+                {
+                    renumbered[handle] = static_cast<uint32_t>(locations.size());
+                    locations.push_back(handleLocations[handle]);
+                }
+            }
+            for (auto &entry : uniformLookup)
+            {
+                entry.second = renumbered[entry.second];
+            }
+            handleLocations = std::move(locations);
+        }
+
+        // Issues the compile and link without reading back any status, so
+        // nothing here waits for the driver
+        std::optional<std::string> compileShader(const std::string &vertexPath, const std::string &fragmentPath, std::string_view defines, const ShaderCache *cache)
         {
-            std::string vertexCode = loadShaderSource(vertexPath);
-            std::string fragmentCode = loadShaderSource(fragmentPath);
+            CORE_TRACE_ZONE("GLShader::compileShader");
+            auto &preprocessor = ShaderPreprocessor::shared();
+            ShaderPreprocessor::Result vertexSource;
+            ShaderPreprocessor::Result fragmentSource;
+            if (auto error = preprocessor.process(vertexPath, defines, vertexSource); error)
+            {
+                return error;
+            }
+            if (auto error = preprocessor.process(fragmentPath, defines, fragmentSource); error)
+            {
+                return error;
+            }
 
-            GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-            GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+            vertexFiles = std::move(vertexSource.files);
+            fragmentFiles = std::move(fragmentSource.files);
 
-            compileSingleShader(vertexShader, vertexCode, "Vertex Shader");
-            compileSingleShader(fragmentShader, fragmentCode, "Fragment Shader");
+            std::optional<uint64_t> cacheKey;
+            if (cache && cache->isEnabled())
+            {
+                cacheKey = cache->makeKey(vertexSource.hash, fragmentSource.hash);
+                if (auto program = cache->load(*cacheKey); program)
+                {
+                    programID = *program;
+                    pending = true;
+                    return std::nullopt;
+                }
+            }
+
+            vertexShader = glCreateShader(GL_VERTEX_SHADER);
+            fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+
+            compileSingleShader(vertexShader, vertexSource.source);
+            compileSingleShader(fragmentShader, fragmentSource.source);
 
             programID = glCreateProgram();
             glAttachShader(programID, vertexShader);
             glAttachShader(programID, fragmentShader);
+            if (cacheKey)
+            {
+                glProgramParameteri(programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+            }
             glLinkProgram(programID);
 
+            pending = true;
+            pendingCache = cache;
+            pendingCacheKey = cacheKey;
+            return std::nullopt;
+        }
+
+        std::optional<std::string> checkProgram()
+        {
+            if (!vertexShader)
+            {
+                // Loaded from the cache, already checked
+                return std::nullopt;
+            }
+
+            checkShader(vertexShader, "Vertex Shader", vertexFiles);
+            checkShader(fragmentShader, "Fragment Shader", fragmentFiles);
+
             GLint success;
             glGetProgramiv(programID, GL_LINK_STATUS, &success);
             if (!success)
@@ -120,32 +492,36 @@ namespace Core::GL
                 return std::string("Shader Program Linking Failed: ") + infoLog;
             }
 
-            glDeleteShader(vertexShader);
-            glDeleteShader(fragmentShader);
+            deleteShaders();
+
+            if (pendingCacheKey)
+            {
+                pendingCache->store(*pendingCacheKey, programID);
+            }
 
             return std::nullopt;
         }
 
-        std::string loadShaderSource(const std::string &path)
+        void deleteShaders()
         {
-            std::ifstream file(path);
-            if (!file)
+            if (vertexShader)
             {
-                std::cerr << "Failed to load shader: " << path << '\n';
-                return "";
+                glDeleteShader(vertexShader);
+                glDeleteShader(fragmentShader);
+                vertexShader = 0;
+                fragmentShader = 0;
             }
-
-            std::stringstream buffer;
-            buffer << file.rdbuf();
-            return buffer.str();
         }
 
-        void compileSingleShader(GLuint shader, const std::string &source, const std::string &name)
+        void compileSingleShader(GLuint shader, const std::string &source)
         {
             const char *sourceCStr = source.c_str();
             glShaderSource(shader, 1, &sourceCStr, nullptr);
             glCompileShader(shader);
+        }
 
+        void checkShader(GLuint shader, const std::string &name, const std::vector<std::string> &files)
+        {
             GLint success;
             glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
             if (!success)
@@ -153,6 +529,10 @@ namespace Core::GL
                 char infoLog[512];
                 glGetShaderInfoLog(shader, sizeof(infoLog), nullptr, infoLog);
                 std::cerr << name << " Compilation Failed: " << infoLog << '\n';
+                for (size_t i = 0; i < files.size(); ++i)
+                {
+                    std::cerr << "  source " << i << ": " << files[i] << '\n';
+                }
             }
         }
 
@@ -194,8 +574,23 @@ namespace Core::GL
                 GLint location = glGetUniformLocation(programID, name);
 
                 uniforms.push_back({name, type, location, size});
-                uniformCache[name] = location;
+                if (location == -1)
+                {
+                    // Uniform block members have no location
+                    continue;
+                }
+
+                auto handle = static_cast<uint32_t>(handleLocations.size());
+                handleLocations.push_back(location);
+                std::string_view uniformName = name;
+                uniformLookup.emplace_back(fnv1a(uniformName), handle);
+                // Arrays are reported as "name[0]", accept the bare name too
+                if (uniformName.ends_with("[0]"))
+                {
+                    uniformLookup.emplace_back(fnv1a(uniformName.substr(0, uniformName.size() - 3)), handle);
+                }
             }
+            std::sort(uniformLookup.begin(), uniformLookup.end());
         }
 
         void reflectUniformBlocks()
@@ -213,27 +608,57 @@ namespace Core::GL
                 glGetActiveUniformBlockiv(programID, index, GL_UNIFORM_BLOCK_DATA_SIZE, &size);
                 glGetActiveUniformBlockiv(programID, index, GL_UNIFORM_BLOCK_BINDING, &binding);
 
-                uniformBlocks.push_back({name, index, size, binding});
+                uniformBlocks.push_back({name, index, size, binding, reflectBlockMembers(index, name)});
             }
         }
 
-        GLint getUniformLocation(const std::string &name)
+        std::vector<UniformBlock::Member> reflectBlockMembers(GLuint blockIndex, std::string_view blockName)
         {
-            if (uniformCache.contains(name))
+            GLint memberCount = 0;
+            glGetActiveUniformBlockiv(programID, blockIndex, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &memberCount);
+            if (memberCount <= 0)
             {
-                return uniformCache[name];
+                return {};
             }
 
-            GLint location = glGetUniformLocation(programID, name.c_str());
-            if (location == -1)
+            std::vector<GLint> indices(memberCount);
+            glGetActiveUniformBlockiv(programID, blockIndex, GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES, indices.data());
+            std::vector<GLuint> uniformIndices(indices.begin(), indices.end());
+
+            auto query = [&](GLenum property)
             {
-                std::cerr << "Warning: Uniform '" << name << "' not found in shader\n";
-            }
-            else
+                std::vector<GLint> values(memberCount);
+                glGetActiveUniformsiv(programID, memberCount, uniformIndices.data(), property, values.data());
+                return values;
+            };
+            std::vector<GLint> types = query(GL_UNIFORM_TYPE);
+            std::vector<GLint> offsets = query(GL_UNIFORM_OFFSET);
+            std::vector<GLint> arrayStrides = query(GL_UNIFORM_ARRAY_STRIDE);
+            std::vector<GLint> matrixStrides = query(GL_UNIFORM_MATRIX_STRIDE);
+            std::vector<GLint> sizes = query(GL_UNIFORM_SIZE);
+
+            std::vector<UniformBlock::Member> members;
+            members.reserve(memberCount);
+            for (GLint i = 0; i < memberCount; ++i)
             {
-                uniformCache[name] = location;
+                GLchar name[256];
+                glGetActiveUniformName(programID, uniformIndices[i], sizeof(name), nullptr, name);
+                // Members of blocks with an instance name come as "Block.member"
+                std::string_view memberName = name;
+                if (memberName.starts_with(blockName) && memberName.size() > blockName.size() && memberName[blockName.size()] == '.')
+                {
+                    memberName.remove_prefix(blockName.size() + 1);
+                }
+                if (memberName.ends_with("[0]"))
+                {
+                    memberName.remove_suffix(3);
+                }
+                members.push_back({std::string(memberName), fnv1a(memberName), static_cast<GLenum>(types[i]),
+                                   offsets[i], arrayStrides[i], matrixStrides[i], sizes[i]});
             }
-            return location;
+            std::sort(members.begin(), members.end(), [](const auto &a, const auto &b)
+                      { return a.offset < b.offset; });
+            return members;
         }
     };
 
@@ -0,0 +1,70 @@
+#include "GLState.hpp"
+
+Core::GL::GLState &Core::GL::GLState::current()
+{
+    thread_local GLState state;
+    return state;
+}
+
+void Core::GL::GLState::onBufferDeleted(GLuint id) noexcept
+{
+    if (id == 0)
+    {
+        return;
+    }
+    if (elementBuffer == id)
+    {
+        elementBuffer = 0;
+    }
+    for (GLuint &bound : buffers)
+    {
+        if (bound == id)
+        {
+            bound = 0;
+        }
+    }
+}
+
+void Core::GL::GLState::onTextureDeleted(GLuint id) noexcept
+{
+    if (id == 0)
+    {
+        return;
+    }
+    for (GLuint &bound : textures2D)
+    {
+        if (bound == id)
+        {
+            bound = 0;
+        }
+    }
+}
+
+void Core::GL::GLState::onVertexArrayDeleted(GLuint id) noexcept
+{
+    if (id != 0 && vertexArray == id)
+    {
+        vertexArray = 0;
+        elementBuffer = unknown;
+    }
+}
+
+void Core::GL::GLState::onProgramDeleted(GLuint id) noexcept
+{
+    // A deleted program stays in use until replaced, but its name may be
+    // reused for a new program which must then be bound for real
+    if (id != 0 && program == id)
+    {
+        program = unknown;
+    }
+}
+
+void Core::GL::GLState::invalidate() noexcept
+{
+    program = unknown;
+    vertexArray = unknown;
+    elementBuffer = unknown;
+    buffers.fill(unknown);
+    activeUnit = unknown;
+    textures2D.fill(unknown);
+}
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace Core::GL
+{
+    // Shadow copy of the bindings core touches, used to skip GL calls that
+    // would not change anything. Every bind in core goes through here; code
+    // that binds directly with gl* calls must call invalidate() afterwards.
+    // One tracker exists per thread, matching the one context a thread can
+    // have current.
+    class GLState
+    {
+    public:
+        static constexpr GLuint maxTextureUnits = 32;
+
+        struct Counters
+        {
+            uint64_t issued = 0;
+            uint64_t elided = 0;
+        };
+
+        struct Statistics
+        {
+            Counters programs;
+            Counters vertexArrays;
+            Counters buffers;
+            Counters textures;
+            // Bytes copied from client memory into buffers and textures
+            uint64_t bytesUploaded = 0;
+        };
+
+    private:
+        static constexpr GLuint unknown = ~0u;
+
+        // Buffer targets that are not part of vertex array state
+        static constexpr std::array<GLenum, 8> bufferTargets = {
+            GL_ARRAY_BUFFER,
+            GL_UNIFORM_BUFFER,
+            GL_SHADER_STORAGE_BUFFER,
+            GL_DRAW_INDIRECT_BUFFER,
+            GL_PIXEL_UNPACK_BUFFER,
+            GL_PIXEL_PACK_BUFFER,
+            GL_COPY_READ_BUFFER,
+            GL_COPY_WRITE_BUFFER,
+        };
+
+        GLuint program = unknown;
+        GLuint vertexArray = unknown;
+        // GL_ELEMENT_ARRAY_BUFFER belongs to the bound vertex array
+        GLuint elementBuffer = unknown;
+        std::array<GLuint, bufferTargets.size()> buffers;
+        GLuint activeUnit = unknown;
+        std::array<GLuint, maxTextureUnits> textures2D;
+        Statistics statistics;
+
+    public:
+        GLState() { invalidate(); }
+
+        static GLState &current();
+
+        void useProgram(GLuint id)
+        {
+            if (program == id)
+            {
+                ++statistics.programs.elided;
+                return;
+            }
+            glUseProgram(id);
+            program = id;
+            ++statistics.programs.issued;
+        }
+
+        void bindVertexArray(GLuint id)
+        {
+            if (vertexArray == id)
+            {
+                ++statistics.vertexArrays.elided;
+                return;
+            }
+            glBindVertexArray(id);
+            vertexArray = id;
+            elementBuffer = unknown;
+            ++statistics.vertexArrays.issued;
+        }
+
+        void bindBuffer(GLenum target, GLuint id)
+        {
+            GLuint *slot = bufferSlot(target);
+            if (slot && *slot == id)
+            {
+                ++statistics.buffers.elided;
+                return;
+            }
+            glBindBuffer(target, id);
+            if (slot)
+            {
+                *slot = id;
+            }
+            ++statistics.buffers.issued;
+        }
+
+        void activeTexture(GLuint unit)
+        {
+            if (activeUnit == unit)
+            {
+                ++statistics.textures.elided;
+                return;
+            }
+            glActiveTexture(GL_TEXTURE0 + unit);
+            activeUnit = unit;
+            ++statistics.textures.issued;
+        }
+
+        // Binds to the currently active unit
+        void bindTexture(GLenum target, GLuint id)
+        {
+            bool tracked = target == GL_TEXTURE_2D && activeUnit < maxTextureUnits;
+            if (tracked && textures2D[activeUnit] == id)
+            {
+                ++statistics.textures.elided;
+                return;
+            }
+            glBindTexture(target, id);
+            if (tracked)
+            {
+                textures2D[activeUnit] = id;
+            }
+            ++statistics.textures.issued;
+        }
+
+        void bindTexture(GLuint unit, GLenum target, GLuint id)
+        {
+            // Skip the unit switch too when the texture is already there
+            if (target == GL_TEXTURE_2D && unit < maxTextureUnits && textures2D[unit] == id)
+            {
+                ++statistics.textures.elided;
+                return;
+            }
+            activeTexture(unit);
+            bindTexture(target, id);
+        }
+
+        // Direct state access bind, leaves the active unit alone
+        void bindTextureUnit(GLuint unit, GLenum target, GLuint id)
+        {
+            bool tracked = target == GL_TEXTURE_2D && unit < maxTextureUnits;
+            if (tracked && textures2D[unit] == id)
+            {
+                ++statistics.textures.elided;
+                return;
+            }
+            glBindTextureUnit(unit, id);
+            if (tracked)
+            {
+                textures2D[unit] = id;
+            }
+            ++statistics.textures.issued;
+        }
+
+        // Indexed binds also replace the generic binding of the target
+        void bindBufferRange(GLenum target, GLuint index, GLuint id, GLintptr offset, GLsizeiptr size)
+        {
+            glBindBufferRange(target, index, id, offset, size);
+            if (GLuint *slot = bufferSlot(target); slot)
+            {
+                *slot = id;
+            }
+            ++statistics.buffers.issued;
+        }
+
+        void bindBufferBase(GLenum target, GLuint index, GLuint id)
+        {
+            glBindBufferBase(target, index, id);
+            if (GLuint *slot = bufferSlot(target); slot)
+            {
+                *slot = id;
+            }
+            ++statistics.buffers.issued;
+        }
+
+        // Called by everything in core that copies data into GL objects
+        void onUpload(size_t bytes) noexcept { statistics.bytesUploaded += bytes; }
+
+        // Deleting a bound object resets its bindings to zero
+        void onBufferDeleted(GLuint id) noexcept;
+        void onTextureDeleted(GLuint id) noexcept;
+        void onVertexArrayDeleted(GLuint id) noexcept;
+        void onProgramDeleted(GLuint id) noexcept;
+
+        // Forget everything, the next bind of each kind is always issued
+        void invalidate() noexcept;
+
+        [[nodiscard]] const Statistics &getStatistics() const noexcept { return statistics; }
+        void resetStatistics() noexcept { statistics = {}; }
+
+    private:
+        GLuint *bufferSlot(GLenum target) noexcept
+        {
+            if (target == GL_ELEMENT_ARRAY_BUFFER)
+            {
+                return &elementBuffer;
+            }
+            for (size_t i = 0; i < bufferTargets.size(); ++i)
+            {
+                if (bufferTargets[i] == target)
+                {
+                    return &buffers[i];
+                }
+            }
+            return nullptr;
+        }
+    };
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <iostream>
+
+#include "GLBuffer.hpp"
+#include "GLState.hpp"
+
+namespace Core::GL
+{
+    // Persistently mapped buffer for data rewritten every frame. The storage
+    // is split into regions used round-robin; each region is fenced when the
+    // frame that wrote it is submitted and only handed out again once the GPU
+    // has passed that fence, so writes never race in-flight draws.
+    class GLStreamBuffer
+    {
+    public:
+        static constexpr size_t maxRegions = 4;
+
+    private:
+        std::unique_ptr<GLuint, void (*)(GLuint *)> bufferId;
+        GLenum type;
+        size_t regionSize;
+        size_t regionCount;
+        size_t currentRegion = 0;
+        std::byte *mapped = nullptr;
+        std::array<GLsync, maxRegions> fences{};
+
+    public:
+        // Three regions lets the CPU run two frames ahead of the GPU
+        GLStreamBuffer(BufferType bufferType, size_t bytesPerFrame, size_t regions = 3)
+            : bufferId(new GLuint(0), [](GLuint *id)
+                       { if (id && *id) {
+                GLState::current().onBufferDeleted(*id);
+                glDeleteBuffers(1, id);
+                delete id;
+              } }),
+              type(static_cast<GLenum>(bufferType)),
+              regionSize(alignRegion(bytesPerFrame)),
+              regionCount(regions < 1 ? 1 : regions > maxRegions ? maxRegions : regions)
+        {
+            constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+            glCreateBuffers(1, bufferId.get());
+            glNamedBufferStorage(*bufferId, regionSize * regionCount, nullptr, flags);
+            mapped = static_cast<std::byte *>(glMapNamedBufferRange(*bufferId, 0, regionSize * regionCount, flags));
+
+            if (!mapped)
+            {
+                std::cerr << "Failed to persistently map stream buffer\n";
+            }
+        }
+
+        // The following prevents copying and moving, the mapping and fences
+        // belong to this object
+        GLStreamBuffer(const GLStreamBuffer &) = delete;
+        GLStreamBuffer &operator=(const GLStreamBuffer &) = delete;
+
+        ~GLStreamBuffer()
+        {
+            for (GLsync &fence : fences)
+            {
+                if (fence)
+                {
+                    glDeleteSync(fence);
+                }
+            }
+            if (mapped)
+            {
+                glUnmapNamedBuffer(*bufferId);
+            }
+        }
+
+        // Advances to the next region, waiting for the GPU to finish with it
+        // if necessary, and returns it for writing
+        std::span<std::byte> beginFrame()
+        {
+            if (!mapped)
+            {
+                return {};
+            }
+
+            currentRegion = (currentRegion + 1) % regionCount;
+            if (GLsync &fence = fences[currentRegion]; fence)
+            {
+                GLbitfield waitFlags = 0;
+                while (true)
+                {
+                    GLenum result = glClientWaitSync(fence, waitFlags, 1'000'000);
+                    if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED)
+                    {
+                        break;
+                    }
+                    // Make sure the fence is actually submitted before blocking on it
+                    waitFlags = GL_SYNC_FLUSH_COMMANDS_BIT;
+                }
+                glDeleteSync(fence);
+                fence = nullptr;
+            }
+
+            return {mapped + getRegionOffset(), regionSize};
+        }
+
+        // Call after the draws reading the current region have been issued
+        void endFrame()
+        {
+            if (GLsync &fence = fences[currentRegion]; !fence)
+            {
+                fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            }
+        }
+
+        // Binds the current region to an indexed target such as a uniform block
+        void bindRange(GLuint index) const
+        {
+            GLState::current().bindBufferRange(type, index, *bufferId, static_cast<GLintptr>(getRegionOffset()), static_cast<GLsizeiptr>(regionSize));
+        }
+
+        void bind() const
+        {
+            GLState::current().bindBuffer(type, *bufferId);
+        }
+
+        void unbind() const
+        {
+            GLState::current().bindBuffer(type, 0);
+        }
+
+        [[nodiscard]] GLuint getID() const noexcept { return *bufferId; }
+        [[nodiscard]] size_t getRegionOffset() const noexcept { return currentRegion * regionSize; }
+        [[nodiscard]] size_t getRegionSize() const noexcept { return regionSize; }
+        [[nodiscard]] bool isMapped() const noexcept { return mapped != nullptr; }
+
+    private:
+        // Region starts must satisfy the strictest offset alignment for
+        // glBindBufferRange, 256 covers every desktop driver
+        static size_t alignRegion(size_t size) noexcept
+        {
+            constexpr size_t alignment = 256;
+            return (size + alignment - 1) / alignment * alignment;
+        }
+    };
+}
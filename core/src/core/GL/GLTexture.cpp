@@ -3,41 +3,97 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 #include "GLTexture.hpp"
+#include "../Trace.hpp"
+#include "Mipmap.hpp"
 #include <iostream>
 
-bool Core::GL::GLTexture::loadFromFile(const std::string &filePath)
+bool Core::GL::GLTexture::loadFromFile(const std::string &filePath, MipmapMode mipmaps, ColorSpace colorSpace)
 {
-    glBindTexture(textureType, *textureId);
-
+    CORE_TRACE_ZONE("GLTexture::loadFromFile");
+    int imageWidth, imageHeight, imageChannels;
     stbi_set_flip_vertically_on_load(true);
-    unsigned char *data = stbi_load(filePath.c_str(), &width, &height, &channels, 4);
+    unsigned char *data = stbi_load(filePath.c_str(), &imageWidth, &imageHeight, &imageChannels, 4);
     if (!data)
     {
         std::cerr << "Failed to load texture: " << filePath << std::endl;
         return false;
     }
 
-    glTexImage2D(textureType, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(textureType);
-    stbi_image_free(data);
+    allocate(mipLevelCount(imageWidth, imageHeight), imageWidth, imageHeight);
+    channels = imageChannels;
+    glTextureSubImage2D(*textureId, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    GLState::current().onUpload(static_cast<size_t>(width) * height * 4);
 
-    glTexParameteri(textureType, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(textureType, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(textureType, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(textureType, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    if (mipmaps == MipmapMode::CPU)
+    {
+        size_t size = static_cast<size_t>(width) * height * 4;
+        MipChain chain = generateMipChain({data, size}, width, height, colorSpace, JobSystem::shared());
+        for (size_t level = 0; level < chain.levels.size(); ++level)
+        {
+            const auto &info = chain.levels[level];
+            glTextureSubImage2D(*textureId, static_cast<GLint>(level + 1), 0, 0, info.width, info.height, GL_RGBA, GL_UNSIGNED_BYTE, chain.getLevelData(level));
+            GLState::current().onUpload(static_cast<size_t>(info.width) * info.height * 4);
+        }
+    }
+    else
+    {
+        glGenerateTextureMipmap(*textureId);
+    }
+    stbi_image_free(data);
 
-    unbind();
+    glTextureParameteri(*textureId, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTextureParameteri(*textureId, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTextureParameteri(*textureId, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTextureParameteri(*textureId, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
     return true;
 }
 
 void Core::GL::GLTexture::bind(GLuint unit) const
 {
-    glActiveTexture(GL_TEXTURE0 + unit);
-    glBindTexture(textureType, *textureId);
+    GLState::current().bindTextureUnit(unit, textureType, *textureId);
 }
 
 void Core::GL::GLTexture::unbind() const
 {
-    glBindTexture(textureType, 0);
-}
\ No newline at end of file
+    GLState::current().bindTexture(textureType, 0);
+}
+
+void Core::GL::GLTexture::setSolidColor(unsigned char r, unsigned char g, unsigned char b, unsigned char a)
+{
+    const unsigned char texel[4] = {r, g, b, a};
+
+    allocate(1, 1, 1);
+    channels = 4;
+    glTextureSubImage2D(*textureId, 0, 0, 0, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, texel);
+    GLState::current().onUpload(sizeof(texel));
+    glTextureParameteri(*textureId, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTextureParameteri(*textureId, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+void Core::GL::GLTexture::allocate(GLsizei levels, int newWidth, int newHeight)
+{
+    if (width != 0)
+    {
+        // Storage is immutable, start over with a fresh texture object
+        GLuint fresh;
+        glCreateTextures(textureType, 1, &fresh);
+        replace(fresh, 0, 0, 0);
+    }
+    glTextureStorage2D(*textureId, levels, GL_RGBA8, newWidth, newHeight);
+    width = newWidth;
+    height = newHeight;
+}
+
+void Core::GL::GLTexture::replace(GLuint id, int newWidth, int newHeight, int newChannels)
+{
+    if (*textureId)
+    {
+        GLState::current().onTextureDeleted(*textureId);
+        glDeleteTextures(1, textureId.get());
+    }
+    *textureId = id;
+    width = newWidth;
+    height = newHeight;
+    channels = newChannels;
+}
@@ -5,16 +5,31 @@
 #include <memory>
 #include <optional>
 
+#include "GLState.hpp"
+#include "Mipmap.hpp"
+
 namespace Core::GL
 {
+    enum class MipmapMode
+    {
+        // glGenerateTextureMipmap on the GL thread
+        Driver,
+        // Levels filtered on the job system and uploaded one by one
+        CPU
+    };
+
+    // Immutable texture storage edited through direct state access. Loading
+    // into a texture that already has storage swaps in a new texture object.
     class GLTexture
     {
     private:
         std::unique_ptr<GLuint, void (*)(GLuint *)> textureId;
         GLenum textureType;
-        int width;
-        int height;
-        int channels;
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+
+        friend class TextureLoader;
 
     public:
         explicit GLTexture(GLenum type = GL_TEXTURE_2D)
@@ -22,14 +37,19 @@ namespace Core::GL
               textureId(new GLuint(0), [](GLuint *id)
                         {
                 if (id && *id) {
+                    GLState::current().onTextureDeleted(*id);
                     glDeleteTextures(1, id);
                     delete id;
                 } })
         {
-            glGenTextures(1, textureId.get());
+            glCreateTextures(type, 1, textureId.get());
         }
 
-        bool loadFromFile(const std::string &filePath);
+        // The colour space only applies to MipmapMode::CPU, the driver
+        // filters the stored values as they are
+        bool loadFromFile(const std::string &filePath, MipmapMode mipmaps = MipmapMode::Driver, ColorSpace colorSpace = ColorSpace::Srgb);
+        // Fills the texture with a single RGBA texel
+        void setSolidColor(unsigned char r, unsigned char g, unsigned char b, unsigned char a = 255);
         void bind(GLuint uint = 0) const;
         void unbind() const;
 
@@ -37,5 +57,13 @@ namespace Core::GL
         [[nodiscard]] int getWidth() const { return width; }
         [[nodiscard]] int getHeight() const { return height; }
         [[nodiscard]] int getChannels() const { return channels; }
+
+    private:
+        // RGBA8 storage with the given number of levels
+        void allocate(GLsizei levels, int newWidth, int newHeight);
+
+        // Takes ownership of an already filled texture object in place of
+        // the current one, so existing references pick it up
+        void replace(GLuint id, int newWidth, int newHeight, int newChannels);
     };
 }
\ No newline at end of file
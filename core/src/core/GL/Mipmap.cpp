@@ -0,0 +1,259 @@
+#include "Mipmap.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "../Trace.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#define CORE_MIPMAP_SSE2 1
+// The 256-bit path is compiled for AVX2 whatever the build flags and only
+// taken when the CPU has it
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define CORE_MIPMAP_AVX2 1
+#endif
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define CORE_MIPMAP_NEON 1
+#endif
+
+namespace
+{
+    // Rows per job; each output row touches two input rows
+    constexpr size_t rowGrainSize = 16;
+    constexpr int encodeTableSize = 4096;
+
+    struct GammaTables
+    {
+        std::array<float, 256> toLinear;
+        std::array<unsigned char, encodeTableSize + 1> toSrgb;
+
+        GammaTables()
+        {
+            for (int i = 0; i < 256; ++i)
+            {
+                float c = i / 255.0f;
+                toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            for (int i = 0; i <= encodeTableSize; ++i)
+            {
+                float l = static_cast<float>(i) / encodeTableSize;
+                float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+                toSrgb[i] = static_cast<unsigned char>(std::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f));
+            }
+        }
+    };
+
+    const GammaTables &gammaTables()
+    {
+        static const GammaTables tables;
+        return tables;
+    }
+
+    void decodeRow(const unsigned char *source, float *out, int width, Core::GL::ColorSpace colorSpace)
+    {
+        if (colorSpace == Core::GL::ColorSpace::Linear)
+        {
+            for (int i = 0; i < width * 4; ++i)
+            {
+                out[i] = source[i] / 255.0f;
+            }
+            return;
+        }
+
+        const auto &tables = gammaTables();
+        for (int x = 0; x < width; ++x)
+        {
+            out[x * 4 + 0] = tables.toLinear[source[x * 4 + 0]];
+            out[x * 4 + 1] = tables.toLinear[source[x * 4 + 1]];
+            out[x * 4 + 2] = tables.toLinear[source[x * 4 + 2]];
+            out[x * 4 + 3] = source[x * 4 + 3] / 255.0f;
+        }
+    }
+
+    void encodeRow(const float *source, unsigned char *out, int width, Core::GL::ColorSpace colorSpace)
+    {
+        if (colorSpace == Core::GL::ColorSpace::Linear)
+        {
+            for (int i = 0; i < width * 4; ++i)
+            {
+                out[i] = static_cast<unsigned char>(std::clamp(source[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+            }
+            return;
+        }
+
+        const auto &tables = gammaTables();
+        for (int x = 0; x < width * 4; x += 4)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                float value = std::clamp(source[x + c], 0.0f, 1.0f);
+                out[x + c] = tables.toSrgb[static_cast<int>(value * encodeTableSize + 0.5f)];
+            }
+            out[x + 3] = static_cast<unsigned char>(std::clamp(source[x + 3], 0.0f, 1.0f) * 255.0f + 0.5f);
+        }
+    }
+
+#if defined(CORE_MIPMAP_AVX2)
+    // Two output pixels per step, returns how many were written
+    __attribute__((target("avx2"))) int downsampleRowAvx2(const float *row0, const float *row1, float *out, int outWidth)
+    {
+        const __m256 quarter8 = _mm256_set1_ps(0.25f);
+        int x = 0;
+        for (; x + 2 <= outWidth; x += 2)
+        {
+            // Four source pixels per row, two per register
+            __m256 top0 = _mm256_loadu_ps(row0 + x * 8);
+            __m256 top1 = _mm256_loadu_ps(row0 + x * 8 + 8);
+            __m256 bottom0 = _mm256_loadu_ps(row1 + x * 8);
+            __m256 bottom1 = _mm256_loadu_ps(row1 + x * 8 + 8);
+            // Pairs summed within each row first, in the same order as the
+            // SSE2 path, so x86 CPUs with and without AVX2 cook identical levels
+            __m256 top = _mm256_add_ps(_mm256_permute2f128_ps(top0, top1, 0x20), _mm256_permute2f128_ps(top0, top1, 0x31));
+            __m256 bottom = _mm256_add_ps(_mm256_permute2f128_ps(bottom0, bottom1, 0x20), _mm256_permute2f128_ps(bottom0, bottom1, 0x31));
+            _mm256_storeu_ps(out + x * 4, _mm256_mul_ps(_mm256_add_ps(top, bottom), quarter8));
+        }
+        return x;
+    }
+#endif
+
+    // Averages 2x2 blocks of linear RGBA. Only valid when sourceWidth >= 2,
+    // so every output pixel has two source columns.
+    void downsampleRow(const float *row0, const float *row1, float *out, int outWidth)
+    {
+        int x = 0;
+#if defined(CORE_MIPMAP_AVX2)
+        static const bool hasAvx2 = []
+        {
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") != 0;
+        }();
+        if (hasAvx2)
+        {
+            x = downsampleRowAvx2(row0, row1, out, outWidth);
+        }
+#endif
+#if defined(CORE_MIPMAP_SSE2)
+        const __m128 quarter = _mm_set1_ps(0.25f);
+        for (; x < outWidth; ++x)
+        {
+            __m128 top = _mm_add_ps(_mm_loadu_ps(row0 + x * 8), _mm_loadu_ps(row0 + x * 8 + 4));
+            __m128 bottom = _mm_add_ps(_mm_loadu_ps(row1 + x * 8), _mm_loadu_ps(row1 + x * 8 + 4));
+            _mm_storeu_ps(out + x * 4, _mm_mul_ps(_mm_add_ps(top, bottom), quarter));
+        }
+#elif defined(CORE_MIPMAP_NEON)
+        for (; x < outWidth; ++x)
+        {
+            float32x4_t top = vaddq_f32(vld1q_f32(row0 + x * 8), vld1q_f32(row0 + x * 8 + 4));
+            float32x4_t bottom = vaddq_f32(vld1q_f32(row1 + x * 8), vld1q_f32(row1 + x * 8 + 4));
+            vst1q_f32(out + x * 4, vmulq_n_f32(vaddq_f32(top, bottom), 0.25f));
+        }
+#endif
+        for (; x < outWidth; ++x)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                out[x * 4 + c] = (row0[x * 8 + c] + row0[x * 8 + 4 + c] + row1[x * 8 + c] + row1[x * 8 + 4 + c]) * 0.25f;
+            }
+        }
+    }
+
+    // Single column images only ever blend vertically
+    void downsampleColumn(const float *row0, const float *row1, float *out)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            out[c] = (row0[c] + row1[c]) * 0.5f;
+        }
+    }
+}
+
+int Core::GL::mipLevelCount(int width, int height) noexcept
+{
+    int levels = 1;
+    for (int size = std::max(width, height); size > 1; size /= 2)
+    {
+        ++levels;
+    }
+    return levels;
+}
+
+Core::GL::MipChain Core::GL::generateMipChain(std::span<const unsigned char> rgba, int width, int height, ColorSpace colorSpace, JobSystem &jobs)
+{
+    CORE_TRACE_ZONE("generateMipChain");
+    MipChain chain;
+    if (width <= 0 || height <= 0 || rgba.size() < static_cast<size_t>(width) * height * 4)
+    {
+        return chain;
+    }
+
+    size_t total = 0;
+    for (int w = width, h = height; w > 1 || h > 1;)
+    {
+        w = std::max(1, w / 2);
+        h = std::max(1, h / 2);
+        chain.levels.push_back({w, h, total});
+        total += static_cast<size_t>(w) * h * 4;
+    }
+    chain.data.resize(total);
+
+    // Float copy of the previous level, in linear light for Srgb images; the
+    // next one is built from it
+    std::vector<float> previous;
+    int sourceWidth = width;
+    int sourceHeight = height;
+    for (size_t level = 0; level < chain.levels.size(); ++level)
+    {
+        const auto &info = chain.levels[level];
+        std::vector<float> current(static_cast<size_t>(info.width) * info.height * 4);
+        unsigned char *encoded = chain.data.data() + info.offset;
+
+        jobs.parallelFor(info.height, rowGrainSize, [&](size_t begin, size_t end)
+                         {
+            std::vector<float> scratch;
+            if (level == 0)
+            {
+                scratch.resize(static_cast<size_t>(sourceWidth) * 8);
+            }
+
+            for (size_t y = begin; y < end; ++y)
+            {
+                int y0 = static_cast<int>(y) * 2;
+                int y1 = std::min(y0 + 1, sourceHeight - 1);
+
+                const float *row0;
+                const float *row1;
+                if (level == 0)
+                {
+                    decodeRow(rgba.data() + static_cast<size_t>(y0) * sourceWidth * 4, scratch.data(), sourceWidth, colorSpace);
+                    decodeRow(rgba.data() + static_cast<size_t>(y1) * sourceWidth * 4, scratch.data() + sourceWidth * 4, sourceWidth, colorSpace);
+                    row0 = scratch.data();
+                    row1 = scratch.data() + sourceWidth * 4;
+                }
+                else
+                {
+                    row0 = previous.data() + static_cast<size_t>(y0) * sourceWidth * 4;
+                    row1 = previous.data() + static_cast<size_t>(y1) * sourceWidth * 4;
+                }
+
+                float *out = current.data() + y * info.width * 4;
+                if (sourceWidth >= 2)
+                {
+                    downsampleRow(row0, row1, out, info.width);
+                }
+                else
+                {
+                    downsampleColumn(row0, row1, out);
+                }
+                encodeRow(out, encoded + y * info.width * 4, info.width, colorSpace);
+            } });
+
+        previous = std::move(current);
+        sourceWidth = info.width;
+        sourceHeight = info.height;
+    }
+
+    return chain;
+}
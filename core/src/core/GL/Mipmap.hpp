@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include "../JobSystem.hpp"
+
+namespace Core::GL
+{
+    // How the colour channels of RGBA8 texels are encoded
+    enum class ColorSpace
+    {
+        // Base colour and emissive images, filtered in linear light
+        Srgb,
+        // Data such as normals or metallic-roughness, filtered as stored
+        Linear
+    };
+
+    // Mip levels below a base RGBA8 image, all stored in one allocation
+    struct MipChain
+    {
+        struct Level
+        {
+            int width;
+            int height;
+            size_t offset;
+        };
+
+        std::vector<Level> levels;
+        std::vector<unsigned char> data;
+
+        [[nodiscard]] const unsigned char *getLevelData(size_t level) const noexcept { return data.data() + levels[level].offset; }
+    };
+
+    // Number of levels in a full chain, including the base image
+    [[nodiscard]] int mipLevelCount(int width, int height) noexcept;
+
+    // Builds levels 1..n of a full mip chain with a 2x2 box filter. For
+    // Srgb images colour channels are averaged in linear space and
+    // re-encoded as sRGB; alpha, and every channel of Linear images, is
+    // averaged as is. Rows of each level are spread across the job system and
+    // filtered with SSE2/NEON, or AVX2 when the CPU has it.
+    MipChain generateMipChain(std::span<const unsigned char> rgba, int width, int height, ColorSpace colorSpace, JobSystem &jobs);
+}
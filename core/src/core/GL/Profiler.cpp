@@ -0,0 +1,157 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <string>
+
+namespace
+{
+    thread_local Core::GL::Profiler *activeProfiler = nullptr;
+}
+
+Core::GL::Profiler::Profiler()
+    : previous(activeProfiler)
+{
+    for (Frame &frame : frames)
+    {
+        glCreateQueries(GL_TIMESTAMP, static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+        frame.records.reserve(maxZones);
+    }
+    activeProfiler = this;
+}
+
+Core::GL::Profiler::~Profiler()
+{
+    for (Frame &frame : frames)
+    {
+        glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+    }
+    if (activeProfiler == this)
+    {
+        activeProfiler = previous;
+    }
+}
+
+Core::GL::Profiler *Core::GL::Profiler::active() noexcept
+{
+    return activeProfiler;
+}
+
+void Core::GL::Profiler::beginFrame()
+{
+    ++frameCounter;
+    currentFrame = frameCounter % frameLatency;
+
+    // This slot was last filled frameLatency frames ago
+    Frame &frame = frames[currentFrame];
+    if (frame.pending)
+    {
+        collect(frame);
+    }
+    frame.records.clear();
+    frame.lastQuery = 0;
+    frame.index = frameCounter;
+    inFrame = true;
+    depth = 0;
+}
+
+void Core::GL::Profiler::endFrame()
+{
+    frames[currentFrame].pending = frames[currentFrame].lastQuery != 0;
+    inFrame = false;
+}
+
+size_t Core::GL::Profiler::beginZone(const char *name)
+{
+    Frame &frame = frames[currentFrame];
+    if (!inFrame || frame.records.size() == maxZones)
+    {
+        return noZone;
+    }
+
+    size_t zone = frame.records.size();
+    frame.records.push_back({name, depth++, Clock::now(), {}, false});
+    glQueryCounter(frame.queries[zone * 2], GL_TIMESTAMP);
+    frame.lastQuery = frame.queries[zone * 2];
+    return zone;
+}
+
+void Core::GL::Profiler::endZone(size_t zone)
+{
+    Frame &frame = frames[currentFrame];
+    if (zone == noZone || !inFrame || zone >= frame.records.size())
+    {
+        return;
+    }
+
+    glQueryCounter(frame.queries[zone * 2 + 1], GL_TIMESTAMP);
+    frame.lastQuery = frame.queries[zone * 2 + 1];
+    frame.records[zone].cpuEnd = Clock::now();
+    frame.records[zone].closed = true;
+    --depth;
+}
+
+void Core::GL::Profiler::collect(Frame &frame)
+{
+    frame.pending = false;
+
+    // Queries complete in order, so the last one tells about all of them
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(frame.lastQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+    {
+        ++droppedFrames;
+        return;
+    }
+
+    // Pair the GL clock with the trace clock to place GPU zones on the
+    // trace timeline
+    bool tracing = Trace::isEnabled();
+    int64_t gpuToTrace = 0;
+    if (tracing)
+    {
+        GLint64 gpuNow = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+        gpuToTrace = static_cast<int64_t>(Trace::now()) - gpuNow;
+    }
+
+    results.clear();
+    for (size_t i = 0; i < frame.records.size(); ++i)
+    {
+        const Record &record = frame.records[i];
+        if (!record.closed)
+        {
+            // Still open when the frame ended, its end query was never issued
+            continue;
+        }
+        GLuint64 begin = 0;
+        GLuint64 end = 0;
+        glGetQueryObjectui64v(frame.queries[i * 2], GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(frame.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+
+        results.push_back({record.name,
+                           record.depth,
+                           std::chrono::duration<double, std::milli>(record.cpuEnd - record.cpuBegin).count(),
+                           static_cast<double>(end - begin) / 1e6});
+        if (tracing)
+        {
+            auto toTrace = [&](GLuint64 time)
+            { return static_cast<uint64_t>(std::max<int64_t>(0, static_cast<int64_t>(time) + gpuToTrace)); };
+            Trace::recordOnTrack("GPU", record.name, toTrace(begin), toTrace(end));
+        }
+    }
+    resultFrame = frame.index;
+}
+
+void Core::GL::Profiler::printSummary(std::ostream &out) const
+{
+    out << "Frame " << resultFrame << " (" << droppedFrames << " dropped)\n";
+    for (const Zone &zone : results)
+    {
+        out << std::string(zone.depth * 2 + 2, ' ') << std::left << std::setw(std::max(8, 32 - static_cast<int>(zone.depth) * 2)) << zone.name
+            << std::right << std::fixed << std::setprecision(3)
+            << " cpu " << std::setw(8) << zone.cpuMs << " ms"
+            << "  gpu " << std::setw(8) << zone.gpuMs << " ms\n";
+    }
+    out.unsetf(std::ios::floatfield);
+}
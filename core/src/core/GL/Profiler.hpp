@@ -0,0 +1,152 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "../Trace.hpp"
+
+// Zones cost nothing unless core is built with CORE_PROFILER. Profiler zones
+// are trace zones as well.
+#ifdef CORE_PROFILER
+#define CORE_PROFILE_CONCAT_INNER(a, b) a##b
+#define CORE_PROFILE_CONCAT(a, b) CORE_PROFILE_CONCAT_INNER(a, b)
+#define CORE_PROFILE_ZONE(name)   \
+    CORE_TRACE_ZONE(name);        \
+    ::Core::GL::Profiler::Scope CORE_PROFILE_CONCAT(coreProfileZone, __LINE__)(name)
+#define CORE_PROFILE_BEGIN_FRAME()                                    \
+    do                                                                \
+    {                                                                 \
+        if (auto *coreProfiler = ::Core::GL::Profiler::active())      \
+            coreProfiler->beginFrame();                               \
+    } while (false)
+#define CORE_PROFILE_END_FRAME()                                      \
+    do                                                                \
+    {                                                                 \
+        if (auto *coreProfiler = ::Core::GL::Profiler::active())      \
+            coreProfiler->endFrame();                                 \
+    } while (false)
+#else
+#define CORE_PROFILE_ZONE(name) ((void)0)
+#define CORE_PROFILE_BEGIN_FRAME() ((void)0)
+#define CORE_PROFILE_END_FRAME() ((void)0)
+#endif
+
+namespace Core::GL
+{
+    // Nested CPU and GPU timing zones. Every zone writes a GL_TIMESTAMP
+    // query at each end (timestamps nest, GL_TIME_ELAPSED queries do not).
+    // Queries live in a ring of frames and are read back frameLatency frames
+    // later; a frame whose results are still not available by then is
+    // dropped instead of waiting on the GPU. Zones are recorded on the
+    // thread that owns the context, through the active profiler of that
+    // thread. While tracing, read back GPU times go to the trace's "GPU"
+    // track, shifted onto the trace clock.
+    class Profiler
+    {
+    public:
+        static constexpr size_t frameLatency = 4;
+        static constexpr size_t maxZones = 256;
+
+        struct Zone
+        {
+            const char *name;
+            uint32_t depth;
+            double cpuMs;
+            double gpuMs;
+        };
+
+        // Opens a zone on the active profiler, if there is one
+        class Scope
+        {
+        private:
+            Profiler *profiler;
+            size_t zone;
+
+        public:
+            explicit Scope(const char *name)
+                : profiler(Profiler::active()),
+                  zone(profiler ? profiler->beginZone(name) : noZone)
+            {
+            }
+
+            ~Scope()
+            {
+                if (profiler)
+                {
+                    profiler->endZone(zone);
+                }
+            }
+
+            Scope(const Scope &) = delete;
+            Scope &operator=(const Scope &) = delete;
+        };
+
+    private:
+        using Clock = std::chrono::steady_clock;
+        static constexpr size_t noZone = ~size_t(0);
+
+        struct Record
+        {
+            const char *name;
+            uint32_t depth;
+            Clock::time_point cpuBegin;
+            Clock::time_point cpuEnd;
+            bool closed;
+        };
+
+        struct Frame
+        {
+            std::vector<Record> records;
+            // Begin and end timestamp for every record
+            std::array<GLuint, maxZones * 2> queries{};
+            // Issued last, so done once everything before it is
+            GLuint lastQuery = 0;
+            bool pending = false;
+            uint64_t index = 0;
+        };
+
+        std::array<Frame, frameLatency> frames;
+        size_t currentFrame = 0;
+        uint64_t frameCounter = 0;
+        bool inFrame = false;
+        uint32_t depth = 0;
+        Profiler *previous;
+
+        std::vector<Zone> results;
+        uint64_t resultFrame = 0;
+        uint64_t droppedFrames = 0;
+
+    public:
+        // Needs a current context, and becomes the active profiler of this
+        // thread until destroyed
+        Profiler();
+        ~Profiler();
+
+        Profiler(const Profiler &) = delete;
+        Profiler &operator=(const Profiler &) = delete;
+
+        [[nodiscard]] static Profiler *active() noexcept;
+
+        void beginFrame();
+        void endFrame();
+
+        size_t beginZone(const char *name);
+        void endZone(size_t zone);
+
+        // Zones of the newest frame whose queries have been read back, in
+        // the order they were opened
+        [[nodiscard]] const std::vector<Zone> &getResults() const noexcept { return results; }
+        [[nodiscard]] uint64_t getResultFrame() const noexcept { return resultFrame; }
+        [[nodiscard]] uint64_t getDroppedFrames() const noexcept { return droppedFrames; }
+
+        // One line per zone, indented by nesting depth
+        void printSummary(std::ostream &out) const;
+
+    private:
+        void collect(Frame &frame);
+    };
+}
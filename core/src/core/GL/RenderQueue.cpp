@@ -0,0 +1,157 @@
+#include "RenderQueue.hpp"
+
+#include <algorithm>
+#include <array>
+
+#include "Profiler.hpp"
+
+uint64_t Core::GL::RenderQueue::makeKey(const DrawPacket &packet, float depth) noexcept
+{
+    depth = std::clamp(depth, 0.0f, 1.0f);
+    if (packet.backToFront)
+    {
+        depth = 1.0f - depth;
+    }
+    auto quantisedDepth = static_cast<uint64_t>(depth * 65535.0f);
+
+    if (packet.backToFront)
+    {
+        // Blending order matters more than state changes
+        return (static_cast<uint64_t>(packet.pass & 0xf) << 60) |
+               (quantisedDepth << 44) |
+               (static_cast<uint64_t>(packet.program & 0xfff) << 32) |
+               (static_cast<uint64_t>(packet.texture & 0xffff) << 16) |
+               static_cast<uint64_t>(packet.vertexArray & 0xffff);
+    }
+    return (static_cast<uint64_t>(packet.pass & 0xf) << 60) |
+           (static_cast<uint64_t>(packet.program & 0xfff) << 48) |
+           (static_cast<uint64_t>(packet.texture & 0xffff) << 32) |
+           (static_cast<uint64_t>(packet.vertexArray & 0xffff) << 16) |
+           quantisedDepth;
+}
+
+void Core::GL::RenderQueue::push(const DrawPacket &packet, float depth)
+{
+    entries.push_back({makeKey(packet, depth), static_cast<uint32_t>(packets.size())});
+    packets.push_back(packet);
+}
+
+void Core::GL::RenderQueue::clear() noexcept
+{
+    packets.clear();
+    entries.clear();
+}
+
+void Core::GL::RenderQueue::sort()
+{
+    // Comparison sorting wins for the handful of packets a small scene has
+    if (entries.size() < 256)
+    {
+        std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b)
+                  { return a.key < b.key; });
+        return;
+    }
+
+    // LSD radix sort, one byte per pass. All histograms come from a single
+    // read of the keys, and bytes every key shares are skipped.
+    std::array<std::array<uint32_t, 256>, 8> histograms{};
+    for (const Entry &entry : entries)
+    {
+        for (size_t byte = 0; byte < 8; ++byte)
+        {
+            ++histograms[byte][(entry.key >> (byte * 8)) & 0xff];
+        }
+    }
+
+    scratch.resize(entries.size());
+    for (size_t byte = 0; byte < 8; ++byte)
+    {
+        auto &histogram = histograms[byte];
+        uint32_t first = static_cast<uint32_t>((entries.front().key >> (byte * 8)) & 0xff);
+        if (histogram[first] == entries.size())
+        {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (uint32_t &count : histogram)
+        {
+            uint32_t bucket = count;
+            count = offset;
+            offset += bucket;
+        }
+        for (const Entry &entry : entries)
+        {
+            scratch[histogram[(entry.key >> (byte * 8)) & 0xff]++] = entry;
+        }
+        entries.swap(scratch);
+    }
+}
+
+void Core::GL::RenderQueue::flush()
+{
+    CORE_PROFILE_ZONE("RenderQueue::flush");
+    statistics = {};
+    statistics.packets = packets.size();
+    if (packets.empty())
+    {
+        return;
+    }
+
+    sort();
+
+    size_t objectCount = std::count_if(packets.begin(), packets.end(), [](const DrawPacket &packet)
+                                       { return packet.objectBlock; });
+    if (objectCount)
+    {
+        objectUniforms.beginFrame(objectCount * objectUniforms.alignedSize(sizeof(glm::mat4)));
+    }
+
+    GLState &state = GLState::current();
+    const DrawPacket *previous = nullptr;
+    for (const Entry &entry : entries)
+    {
+        const DrawPacket &packet = packets[entry.packet];
+        if (!previous || previous->program != packet.program)
+        {
+            state.useProgram(packet.program);
+            ++statistics.programChanges;
+        }
+        if (packet.texture && (!previous || previous->texture != packet.texture))
+        {
+            state.bindTextureUnit(0, GL_TEXTURE_2D, packet.texture);
+            ++statistics.textureChanges;
+        }
+        if (!previous || previous->vertexArray != packet.vertexArray)
+        {
+            state.bindVertexArray(packet.vertexArray);
+            ++statistics.vertexArrayChanges;
+        }
+        if (packet.objectBlock)
+        {
+            if (auto range = objectUniforms.push(packet.transform); range)
+            {
+                objectUniforms.bind(UniformBinding::Object, *range);
+                statistics.objectBytes += sizeof(glm::mat4);
+            }
+        }
+
+        if (packet.indexType)
+        {
+            glDrawElements(packet.mode, packet.count, packet.indexType, reinterpret_cast<const void *>(packet.indexOffset));
+        }
+        else
+        {
+            glDrawArrays(packet.mode, 0, packet.count);
+        }
+        previous = &packet;
+    }
+    state.bindVertexArray(0);
+    if (objectCount)
+    {
+        objectUniforms.endFrame();
+        state.onUpload(statistics.objectBytes);
+    }
+
+    clear();
+}
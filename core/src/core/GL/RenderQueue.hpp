@@ -0,0 +1,107 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "GLState.hpp"
+#include "UniformBuffer.hpp"
+
+namespace Core::GL
+{
+    // Everything needed to issue one draw call
+    struct DrawPacket
+    {
+        GLuint program = 0;
+        GLuint vertexArray = 0;
+        // Bound to unit 0, left alone when 0
+        GLuint texture = 0;
+        GLenum mode = GL_TRIANGLES;
+        GLsizei count = 0;
+        GLenum indexType = 0; // 0 draws with glDrawArrays
+        size_t indexOffset = 0;
+        // Written to the queue's uniform buffer and bound as the Object block
+        // when set. The block must start with the mat4 transform.
+        bool objectBlock = false;
+        glm::mat4 transform{1.0f};
+        // Lower passes are drawn first
+        uint8_t pass = 0;
+        // Transparent passes want the furthest packets first
+        bool backToFront = false;
+    };
+
+    // Draws recorded during a frame, sorted by a 64-bit key before
+    // submission so packets sharing a program, texture and vertex array end
+    // up next to each other and only the first of each run changes state.
+    //
+    //   63..60  pass
+    //   59..48  program
+    //   47..32  texture
+    //   31..16  vertex array
+    //   15..0   depth, front to back
+    //
+    // backToFront packets sort by depth first, so blending sees them
+    // furthest to nearest, and only share state within one depth step:
+    //
+    //   63..60  pass
+    //   59..44  depth, back to front
+    //   43..32  program
+    //   31..16  texture
+    //   15..0   vertex array
+    //
+    // Object names are truncated to their field width. A collision only
+    // costs ordering, submission compares the real names.
+    //
+    // Per-object transforms are packed into one uniform buffer per flush and
+    // switched with glBindBufferRange on UniformBinding::Object, so drawing
+    // makes no glUniform* calls.
+    class RenderQueue
+    {
+    public:
+        struct Statistics
+        {
+            uint64_t packets = 0;
+            uint64_t programChanges = 0;
+            uint64_t textureChanges = 0;
+            uint64_t vertexArrayChanges = 0;
+            uint64_t objectBytes = 0;
+        };
+
+    private:
+        struct Entry
+        {
+            uint64_t key;
+            uint32_t packet;
+        };
+
+        std::vector<DrawPacket> packets;
+        std::vector<Entry> entries;
+        std::vector<Entry> scratch;
+        UniformBuffer objectUniforms;
+        Statistics statistics;
+
+    public:
+        RenderQueue() = default;
+
+        // Depth is normalised device depth in [0, 1], values outside are clamped
+        void push(const DrawPacket &packet, float depth = 0.0f);
+
+        // Sorts and draws every recorded packet, then clears the queue. Each
+        // flush fills the next region of the object buffer, keep it to one
+        // per frame so the CPU does not wait on the GPU.
+        void flush();
+
+        void clear() noexcept;
+
+        [[nodiscard]] static uint64_t makeKey(const DrawPacket &packet, float depth) noexcept;
+
+        [[nodiscard]] size_t size() const noexcept { return packets.size(); }
+        // Counts for the last flush
+        [[nodiscard]] const Statistics &getStatistics() const noexcept { return statistics; }
+
+    private:
+        void sort();
+    };
+}
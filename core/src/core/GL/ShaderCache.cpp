@@ -0,0 +1,163 @@
+#include "ShaderCache.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "../Hash.hpp"
+
+namespace
+{
+    constexpr uint32_t cacheMagic = 0x42504C47; // "GLPB"
+    constexpr uint32_t cacheVersion = 1;
+
+    struct CacheHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t key;
+        uint32_t format;
+        uint32_t length;
+    };
+
+    std::string glString(GLenum name)
+    {
+        const GLubyte *value = glGetString(name);
+        return value ? reinterpret_cast<const char *>(value) : "";
+    }
+}
+
+Core::GL::ShaderCache::ShaderCache(std::string cacheDirectory)
+    : directory(std::move(cacheDirectory))
+{
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats <= 0)
+    {
+        std::cerr << "Shader cache disabled: driver exposes no program binary formats\n";
+        return;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error)
+    {
+        std::cerr << "Shader cache disabled: " << directory << ": " << error.message() << '\n';
+        return;
+    }
+
+    driverId = glString(GL_VENDOR) + '\n' + glString(GL_RENDERER) + '\n' + glString(GL_VERSION);
+    enabled = true;
+}
+
+uint64_t Core::GL::ShaderCache::makeKey(uint64_t vertexSourceHash, uint64_t fragmentSourceHash) const noexcept
+{
+    uint64_t hash = fnv1a(driverId);
+    hash = fnv1a(std::as_bytes(std::span(&vertexSourceHash, 1)), hash);
+    return fnv1a(std::as_bytes(std::span(&fragmentSourceHash, 1)), hash);
+}
+
+std::optional<GLuint> Core::GL::ShaderCache::load(uint64_t key) const
+{
+    if (!enabled)
+    {
+        return std::nullopt;
+    }
+
+    std::ifstream file(entryPath(key), std::ios::binary);
+    if (!file)
+    {
+        return std::nullopt;
+    }
+
+    CacheHeader header{};
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!file || header.magic != cacheMagic || header.version != cacheVersion || header.key != key)
+    {
+        return std::nullopt;
+    }
+
+    // The length comes from disk, only trust it when the rest of the file
+    // holds exactly that many bytes
+    auto start = file.tellg();
+    file.seekg(0, std::ios::end);
+    auto end = file.tellg();
+    if (!file || end - start != static_cast<std::streamoff>(header.length))
+    {
+        return std::nullopt;
+    }
+    file.seekg(start);
+
+    std::vector<char> binary(header.length);
+    file.read(binary.data(), static_cast<std::streamsize>(binary.size()));
+    if (!file)
+    {
+        return std::nullopt;
+    }
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+    // A driver update can invalidate binaries even with matching strings
+    GLint success = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        glDeleteProgram(program);
+        std::error_code error;
+        std::filesystem::remove(entryPath(key), error);
+        return std::nullopt;
+    }
+    return program;
+}
+
+void Core::GL::ShaderCache::store(uint64_t key, GLuint program) const
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+    {
+        return;
+    }
+
+    std::vector<char> binary(static_cast<size_t>(length));
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    CacheHeader header{cacheMagic, cacheVersion, key, format, static_cast<uint32_t>(length)};
+
+    // Write then rename so a concurrent reader never sees a partial entry
+    std::string path = entryPath(key);
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(binary.data(), length);
+        if (!file)
+        {
+            std::cerr << "Failed to write shader cache entry: " << tempPath << '\n';
+            return;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error)
+    {
+        std::filesystem::remove(tempPath, error);
+    }
+}
+
+std::string Core::GL::ShaderCache::entryPath(uint64_t key) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+    return (std::filesystem::path(directory) / name).string();
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <optional>
+
+namespace Core::GL
+{
+    // On-disk cache of linked program binaries. Entries are keyed by the
+    // shader sources together with the GL renderer and version, so a driver
+    // update or a different GPU simply misses instead of loading a binary
+    // the driver would reject.
+    class ShaderCache
+    {
+    private:
+        std::string directory;
+        std::string driverId;
+        bool enabled = false;
+
+    public:
+        // Requires a current context, the driver strings are part of every key
+        explicit ShaderCache(std::string cacheDirectory);
+
+        // Takes the hashes of the preprocessed sources, see
+        // ShaderPreprocessor::Result
+        [[nodiscard]] uint64_t makeKey(uint64_t vertexSourceHash, uint64_t fragmentSourceHash) const noexcept;
+
+        // Returns a linked program, or nothing when the entry is missing or
+        // the driver refuses the stored binary
+        std::optional<GLuint> load(uint64_t key) const;
+
+        // Program must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+        void store(uint64_t key, GLuint program) const;
+
+        [[nodiscard]] bool isEnabled() const noexcept { return enabled; }
+
+    private:
+        std::string entryPath(uint64_t key) const;
+    };
+}
@@ -0,0 +1,268 @@
+#include "ShaderPreprocessor.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <unordered_set>
+
+#include "../Hash.hpp"
+#include "../Trace.hpp"
+
+namespace
+{
+    constexpr size_t maxIncludeDepth = 32;
+
+    std::string normalise(const std::filesystem::path &path)
+    {
+        return path.lexically_normal().generic_string();
+    }
+
+    uint64_t mix(uint64_t value, uint64_t seed) noexcept
+    {
+        return Core::fnv1a(std::as_bytes(std::span(&value, 1)), seed);
+    }
+
+    std::string_view trim(std::string_view text) noexcept
+    {
+        while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+        {
+            text.remove_prefix(1);
+        }
+        while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r'))
+        {
+            text.remove_suffix(1);
+        }
+        return text;
+    }
+
+    // Splits "  #  include <x>" into "include" and "<x>"
+    bool parseDirective(std::string_view line, std::string_view &name, std::string_view &rest) noexcept
+    {
+        line = trim(line);
+        if (line.empty() || line.front() != '#')
+        {
+            return false;
+        }
+        line = trim(line.substr(1));
+        size_t end = std::min(line.find_first_of(" \t"), line.size());
+        name = line.substr(0, end);
+        rest = trim(line.substr(end));
+        return true;
+    }
+
+    std::string lineDirective(size_t line, size_t sourceString)
+    {
+        return "#line " + std::to_string(line) + ' ' + std::to_string(sourceString) + '\n';
+    }
+}
+
+struct Core::GL::ShaderPreprocessor::Expansion
+{
+    std::string_view defines;
+    Result &result;
+    std::vector<std::string> stack;
+    std::unordered_set<std::string> once;
+};
+
+Core::GL::ShaderPreprocessor &Core::GL::ShaderPreprocessor::shared()
+{
+    static ShaderPreprocessor preprocessor;
+    return preprocessor;
+}
+
+void Core::GL::ShaderPreprocessor::addIncludeDirectory(std::string directory)
+{
+    std::lock_guard lock(mutex);
+    includeDirectories.push_back(normalise(directory));
+}
+
+void Core::GL::ShaderPreprocessor::invalidate(const std::string &path)
+{
+    std::lock_guard lock(mutex);
+    files.erase(normalise(path));
+}
+
+size_t Core::GL::ShaderPreprocessor::getCachedFileCount() const
+{
+    std::lock_guard lock(mutex);
+    return files.size();
+}
+
+std::optional<std::string> Core::GL::ShaderPreprocessor::process(const std::string &path, std::string_view defines, Result &result)
+{
+    CORE_TRACE_ZONE("ShaderPreprocessor::process");
+    result = {};
+    result.hash = fnv1a(defines);
+    Expansion expansion{defines, result, {}, {}};
+    return expand(normalise(path), expansion);
+}
+
+std::shared_ptr<const Core::GL::ShaderPreprocessor::File> Core::GL::ShaderPreprocessor::read(const std::string &path)
+{
+    std::lock_guard lock(mutex);
+    if (auto it = files.find(path); it != files.end())
+    {
+        return it->second;
+    }
+
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if (!stream)
+    {
+        return nullptr;
+    }
+    auto file = std::make_shared<File>();
+    file->text.resize(static_cast<size_t>(stream.tellg()));
+    stream.seekg(0);
+    stream.read(file->text.data(), static_cast<std::streamsize>(file->text.size()));
+    if (!stream)
+    {
+        return nullptr;
+    }
+    file->hash = fnv1a(file->text);
+
+    files.emplace(path, file);
+    return file;
+}
+
+std::optional<std::string> Core::GL::ShaderPreprocessor::resolve(std::string_view name, bool quoted, const std::string &includer) const
+{
+    std::error_code error;
+    if (quoted)
+    {
+        auto candidate = std::filesystem::path(includer).parent_path() / name;
+        if (std::filesystem::is_regular_file(candidate, error))
+        {
+            return normalise(candidate);
+        }
+    }
+
+    std::lock_guard lock(mutex);
+    for (const auto &directory : includeDirectories)
+    {
+        auto candidate = std::filesystem::path(directory) / name;
+        if (std::filesystem::is_regular_file(candidate, error))
+        {
+            return normalise(candidate);
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> Core::GL::ShaderPreprocessor::expand(const std::string &path, Expansion &expansion)
+{
+    auto &stack = expansion.stack;
+    auto &result = expansion.result;
+    if (std::find(stack.begin(), stack.end(), path) != stack.end())
+    {
+        return "Recursive include of " + path;
+    }
+    if (stack.size() == maxIncludeDepth)
+    {
+        return "Includes nested too deeply at " + path;
+    }
+
+    auto file = read(path);
+    if (!file)
+    {
+        return stack.empty() ? "Failed to load shader: " + path : "Failed to load include: " + path;
+    }
+    result.hash = mix(file->hash, result.hash);
+
+    size_t sourceString = std::find(result.files.begin(), result.files.end(), path) - result.files.begin();
+    if (sourceString == result.files.size())
+    {
+        result.files.push_back(path);
+    }
+
+    bool root = stack.empty();
+    std::string_view text = file->text;
+    if (root && text.find("#version") == std::string_view::npos)
+    {
+        result.source += expansion.defines;
+        if (!expansion.defines.empty() && expansion.defines.back() != '\n')
+        {
+            result.source += '\n';
+        }
+        result.source += lineDirective(1, sourceString);
+    }
+    else if (!root)
+    {
+        result.source += lineDirective(1, sourceString);
+    }
+    stack.push_back(path);
+
+    size_t lineNumber = 0;
+    while (!text.empty())
+    {
+        size_t end = text.find('\n');
+        std::string_view line = text.substr(0, end);
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+        ++lineNumber;
+
+        auto fail = [&](const std::string &message)
+        { return path + ":" + std::to_string(lineNumber) + ": " + message; };
+
+        std::string_view name, rest;
+        if (!parseDirective(line, name, rest))
+        {
+            result.source.append(line);
+            result.source += '\n';
+            continue;
+        }
+
+        if (name == "version")
+        {
+            if (!root)
+            {
+                return fail("#version in an included file");
+            }
+            result.source.append(line);
+            result.source += '\n';
+            result.source += expansion.defines;
+            if (!expansion.defines.empty() && expansion.defines.back() != '\n')
+            {
+                result.source += '\n';
+            }
+            result.source += lineDirective(lineNumber + 1, sourceString);
+        }
+        else if (name == "pragma" && rest == "once")
+        {
+            expansion.once.insert(path);
+            result.source += '\n';
+        }
+        else if (name == "include")
+        {
+            bool quoted = rest.size() >= 2 && rest.front() == '"' && rest.back() == '"';
+            bool angled = rest.size() >= 2 && rest.front() == '<' && rest.back() == '>';
+            if (!quoted && !angled)
+            {
+                return fail("#include expects \"file\" or <file>");
+            }
+            std::string_view includeName = rest.substr(1, rest.size() - 2);
+            auto resolved = resolve(includeName, quoted, path);
+            if (!resolved)
+            {
+                return fail("Cannot find include '" + std::string(includeName) + "'");
+            }
+            if (expansion.once.contains(*resolved))
+            {
+                result.source += '\n';
+                continue;
+            }
+            if (auto error = expand(*resolved, expansion); error)
+            {
+                return error;
+            }
+            result.source += lineDirective(lineNumber + 1, sourceString);
+        }
+        else
+        {
+            result.source.append(line);
+            result.source += '\n';
+        }
+    }
+
+    stack.pop_back();
+    return std::nullopt;
+}
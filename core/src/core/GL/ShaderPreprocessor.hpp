@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Core::GL
+{
+    // Expands #include directives in GLSL sources. Files are read once and
+    // kept in memory with their hash, so a shader library shared by many
+    // programs and variants is loaded from disk once per process.
+    //
+    // #include "file" is looked up next to the including file first, then in
+    // the include directories; #include <file> only in the include
+    // directories. Files containing #pragma once are expanded once per
+    // source. Every file gets a GLSL source string number and the output
+    // carries #line directives, so compiler messages of the form
+    // "<number>:<line>" point at the right file and line. Directives are
+    // recognised at the start of a line only, including inside comments.
+    class ShaderPreprocessor
+    {
+    public:
+        struct Result
+        {
+            std::string source;
+            // Identifies the expanded source: the defines and the hash of
+            // every file in expansion order, without rehashing the output
+            uint64_t hash = 0;
+            // Path for each source string number used in #line
+            std::vector<std::string> files;
+        };
+
+    private:
+        struct File
+        {
+            std::string text;
+            uint64_t hash;
+        };
+
+        std::vector<std::string> includeDirectories;
+        std::unordered_map<std::string, std::shared_ptr<const File>> files;
+        mutable std::mutex mutex;
+
+    public:
+        ShaderPreprocessor() = default;
+
+        ShaderPreprocessor(const ShaderPreprocessor &) = delete;
+        ShaderPreprocessor &operator=(const ShaderPreprocessor &) = delete;
+
+        // Process-wide instance used by GLShader
+        static ShaderPreprocessor &shared();
+
+        void addIncludeDirectory(std::string directory);
+
+        // Defines are lines such as "#define HAS_NORMAL_MAP\n", placed right
+        // after #version
+        std::optional<std::string> process(const std::string &path, std::string_view defines, Result &result);
+
+        // Drops a file from the cache so the next process() reads it again
+        void invalidate(const std::string &path);
+
+        [[nodiscard]] size_t getCachedFileCount() const;
+
+    private:
+        struct Expansion;
+
+        std::shared_ptr<const File> read(const std::string &path);
+        std::optional<std::string> expand(const std::string &path, Expansion &expansion);
+        std::optional<std::string> resolve(std::string_view name, bool quoted, const std::string &includer) const;
+    };
+}
@@ -0,0 +1,115 @@
+#include "ShaderReloader.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+
+#include "ShaderPreprocessor.hpp"
+
+void Core::GL::ShaderReloader::watch(GLShader &shader)
+{
+    shaders.push_back(&shader);
+}
+
+void Core::GL::ShaderReloader::watch(ShaderVariants &variants)
+{
+    variantSets.push_back(&variants);
+}
+
+std::vector<Core::GL::GLShader *> Core::GL::ShaderReloader::collectTargets()
+{
+    std::vector<GLShader *> targets = shaders;
+    for (ShaderVariants *variants : variantSets)
+    {
+        variants->forEachVariant([&](GLShader &shader)
+                                 { targets.push_back(&shader); });
+    }
+    return targets;
+}
+
+void Core::GL::ShaderReloader::registerTarget(const GLShader &shader)
+{
+    if (!registered.insert(&shader).second)
+    {
+        return;
+    }
+    for (const auto &file : shader.getSourceFiles())
+    {
+        std::string directory = std::filesystem::path(file).parent_path().generic_string();
+        if (directory.empty())
+        {
+            directory = ".";
+        }
+        if (auto error = watcher.watchDirectory(directory); error)
+        {
+            std::cerr << "Shader reload: " << *error << '\n';
+        }
+    }
+}
+
+size_t Core::GL::ShaderReloader::update()
+{
+    std::vector<GLShader *> targets = collectTargets();
+    for (GLShader *target : targets)
+    {
+        registerTarget(*target);
+    }
+
+    std::vector<std::string> changed = watcher.poll();
+    if (!changed.empty())
+    {
+        for (const auto &file : changed)
+        {
+            ShaderPreprocessor::shared().invalidate(file);
+        }
+        for (GLShader *target : targets)
+        {
+            bool affected = std::any_of(changed.begin(), changed.end(), [&](const std::string &file)
+                                        { return target->dependsOn(file); });
+            if (!affected)
+            {
+                continue;
+            }
+
+            // A newer edit restarts a rebuild still in flight
+            auto reload = std::find_if(reloads.begin(), reloads.end(), [&](const Reload &entry)
+                                       { return entry.target == target; });
+            if (reload != reloads.end())
+            {
+                reload->replacement = target->recompile();
+            }
+            else
+            {
+                reloads.push_back({target, target->recompile()});
+            }
+        }
+    }
+
+    size_t swapped = 0;
+    for (auto it = reloads.begin(); it != reloads.end();)
+    {
+        if (!it->replacement->isReady())
+        {
+            ++it;
+            continue;
+        }
+
+        it->replacement->finish();
+        auto files = it->target->getSourceFiles();
+        std::string name = files.empty() ? "shader" : files.front();
+        if (it->replacement->isLinked())
+        {
+            it->target->swap(*it->replacement);
+            // The new sources may include different files
+            registered.erase(it->target);
+            std::cout << "Reloaded " << name << '\n';
+            ++swapped;
+        }
+        else
+        {
+            std::cerr << "Keeping the previous program for " << name << '\n';
+        }
+        it = reloads.erase(it);
+    }
+    return swapped;
+}
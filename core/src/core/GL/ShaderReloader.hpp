@@ -0,0 +1,58 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "../FileWatcher.hpp"
+#include "GLShader.hpp"
+#include "ShaderVariants.hpp"
+
+namespace Core::GL
+{
+    // Rebuilds shaders whose sources change on disk while the program runs.
+    // Every file a shader was built from is watched, includes too. A change
+    // drops the file from the preprocessor cache and starts a deferred
+    // compile of just the shaders that read it, so the driver builds them
+    // in the background (in parallel where GL_KHR_parallel_shader_compile is
+    // there) while frames keep rendering with the old programs. A rebuild
+    // that links is swapped into the existing GLShader object; one that
+    // fails is reported and dropped, and the old program stays.
+    class ShaderReloader
+    {
+    private:
+        struct Reload
+        {
+            GLShader *target;
+            std::unique_ptr<GLShader> replacement;
+        };
+
+        FileWatcher watcher;
+        std::vector<GLShader *> shaders;
+        std::vector<ShaderVariants *> variantSets;
+        std::unordered_set<const GLShader *> registered;
+        std::vector<Reload> reloads;
+
+    public:
+        ShaderReloader() = default;
+
+        ShaderReloader(const ShaderReloader &) = delete;
+        ShaderReloader &operator=(const ShaderReloader &) = delete;
+
+        // Watched shaders and variant sets must outlive the reloader.
+        // Variants built later are picked up by update().
+        void watch(GLShader &shader);
+        void watch(ShaderVariants &variants);
+
+        // Call once per frame on the thread owning the context. Returns how
+        // many programs were swapped in.
+        size_t update();
+
+        [[nodiscard]] size_t getPendingCount() const noexcept { return reloads.size(); }
+
+    private:
+        std::vector<GLShader *> collectTargets();
+        void registerTarget(const GLShader &shader);
+    };
+}
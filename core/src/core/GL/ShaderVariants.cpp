@@ -0,0 +1,59 @@
+#include "ShaderVariants.hpp"
+
+Core::GL::ShaderVariants::ShaderVariants(std::string vertexShaderPath, std::string fragmentShaderPath, std::vector<Feature> featureDefines, const ShaderCache *shaderCache)
+    : vertexPath(std::move(vertexShaderPath)),
+      fragmentPath(std::move(fragmentShaderPath)),
+      features(std::move(featureDefines)),
+      cache(shaderCache)
+{
+    for (const Feature &feature : features)
+    {
+        supported |= feature.bit;
+    }
+}
+
+Core::GL::GLShader &Core::GL::ShaderVariants::get(Features requested)
+{
+    Features variant = mask(requested);
+    auto &program = programs[variant];
+    if (!program)
+    {
+        program = compile(variant, CompileMode::Immediate);
+    }
+    return *program;
+}
+
+void Core::GL::ShaderVariants::prepare(std::span<const Features> requested)
+{
+    std::vector<GLShader *> started;
+    for (Features features : requested)
+    {
+        auto &program = programs[mask(features)];
+        if (!program)
+        {
+            program = compile(mask(features), CompileMode::Deferred);
+            started.push_back(program.get());
+        }
+    }
+    GLShader::finishAll(started);
+}
+
+std::string Core::GL::ShaderVariants::makeDefines(Features requested) const
+{
+    std::string defines;
+    for (const Feature &feature : features)
+    {
+        if (requested & feature.bit)
+        {
+            defines += "#define " + feature.define + '\n';
+        }
+    }
+    return defines;
+}
+
+std::unique_ptr<Core::GL::GLShader> Core::GL::ShaderVariants::compile(Features variant, CompileMode mode) const
+{
+    // The defines are part of the sources, so each variant gets its own
+    // shader cache entry
+    return std::make_unique<GLShader>(vertexPath, fragmentPath, makeDefines(variant), cache, mode);
+}
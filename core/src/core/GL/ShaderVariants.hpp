@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "GLShader.hpp"
+#include "ShaderCache.hpp"
+
+namespace Core::GL
+{
+    // One pair of shader files compiled into a program per feature
+    // combination. Each feature is a bit paired with the #define it enables;
+    // bits the shader has no define for are masked off, so combinations
+    // that would compile to the same program share one. Programs are built
+    // the first time a combination is asked for, or up front and in
+    // parallel through prepare(), and kept until the set is destroyed.
+    class ShaderVariants
+    {
+    public:
+        using Features = uint32_t;
+
+        struct Feature
+        {
+            Features bit;
+            std::string define;
+        };
+
+    private:
+        std::string vertexPath;
+        std::string fragmentPath;
+        std::vector<Feature> features;
+        Features supported = 0;
+        const ShaderCache *cache;
+        std::unordered_map<Features, std::unique_ptr<GLShader>> programs;
+
+    public:
+        ShaderVariants(std::string vertexShaderPath, std::string fragmentShaderPath, std::vector<Feature> featureDefines, const ShaderCache *shaderCache = nullptr);
+
+        // The following prevents copying, but allows moving
+        ShaderVariants(const ShaderVariants &) = delete;
+        ShaderVariants &operator=(const ShaderVariants &) = delete;
+        ShaderVariants(ShaderVariants &&other) noexcept = default;
+        ShaderVariants &operator=(ShaderVariants &&other) noexcept = default;
+
+        // Compiles the variant if this combination is new
+        [[nodiscard]] GLShader &get(Features requested);
+
+        // Starts every missing variant as a deferred compile so the driver
+        // can build them side by side, then waits for all of them
+        void prepare(std::span<const Features> requested);
+
+        // Calls fn(GLShader &) for every variant built so far
+        template <typename Fn>
+        void forEachVariant(Fn &&fn)
+        {
+            for (auto &[variant, program] : programs)
+            {
+                fn(*program);
+            }
+        }
+
+        [[nodiscard]] Features mask(Features requested) const noexcept { return requested & supported; }
+        [[nodiscard]] size_t getVariantCount() const noexcept { return programs.size(); }
+
+        // The #define block for a combination, one line per set feature
+        [[nodiscard]] std::string makeDefines(Features requested) const;
+
+    private:
+        std::unique_ptr<GLShader> compile(Features variant, CompileMode mode) const;
+    };
+}
@@ -0,0 +1,286 @@
+#include "TextureLoader.hpp"
+
+#include <stb_image.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#include "../Hash.hpp"
+#include "../Trace.hpp"
+#include "Profiler.hpp"
+
+namespace
+{
+    constexpr uint32_t textureMagic = 0x58544B43; // "CKTX"
+    // Bumped whenever the sections below or the mip filter change
+    constexpr uint32_t textureVersion = 2;
+
+    struct TextureInfo
+    {
+        int32_t width;
+        int32_t height;
+        int32_t channels;
+        int32_t colorSpace;
+    };
+
+    enum Section : uint32_t
+    {
+        Info,
+        Base,
+        MipLevels,
+        MipData
+    };
+}
+
+Core::GL::TextureLoader::Pending::~Pending()
+{
+    if (pixels)
+    {
+        stbi_image_free(pixels);
+    }
+}
+
+Core::GL::TextureLoader::TextureLoader(size_t uploadBytesPerFrame, JobSystem &jobSystem, std::string cookedCacheDirectory)
+    : jobs(jobSystem),
+      cacheDirectory(std::move(cookedCacheDirectory)),
+      staging(BufferType::PixelUnpack, uploadBytesPerFrame)
+{
+    if (!cacheDirectory.empty())
+    {
+        std::error_code error;
+        std::filesystem::create_directories(cacheDirectory, error);
+        if (error)
+        {
+            std::cerr << "Texture cache disabled: " << cacheDirectory << ": " << error.message() << '\n';
+            cacheDirectory.clear();
+        }
+    }
+}
+
+Core::GL::TextureLoader::~TextureLoader()
+{
+    // Decode jobs may still hold on to their entries, but textures must be
+    // released here on the GL thread. That includes the target, which a job
+    // finishing last would otherwise delete on a worker.
+    for (auto &item : pending)
+    {
+        if (item->texture)
+        {
+            GLState::current().onTextureDeleted(item->texture);
+            glDeleteTextures(1, &item->texture);
+            item->texture = 0;
+        }
+        item->target.reset();
+    }
+}
+
+std::shared_ptr<Core::GL::GLTexture> Core::GL::TextureLoader::loadAsync(const std::string &filePath, ColorSpace colorSpace)
+{
+    auto texture = std::make_shared<GLTexture>();
+    texture->setSolidColor(128, 128, 128);
+
+    auto item = std::make_shared<Pending>();
+    item->path = filePath;
+    item->target = texture;
+    item->colorSpace = colorSpace;
+    pending.push_back(item);
+
+    std::string entry = cacheDirectory.empty() ? std::string() : entryPath(filePath, colorSpace);
+    jobs.submit([item, entry, &system = jobs]
+                {
+        CORE_TRACE_ZONE("TextureLoader::decode");
+        if (entry.empty() || !loadCooked(*item, entry, system))
+        {
+            stbi_set_flip_vertically_on_load_thread(true);
+            item->pixels = stbi_load(item->path.c_str(), &item->width, &item->height, &item->channels, 4);
+            if (!item->pixels)
+            {
+                std::cerr << "Failed to load texture: " << item->path << " (" << stbi_failure_reason() << ")\n";
+            }
+            else
+            {
+                size_t size = static_cast<size_t>(item->width) * item->height * 4;
+                item->mips = generateMipChain({item->pixels, size}, item->width, item->height, item->colorSpace, system);
+                item->levels.push_back({item->width, item->height, item->pixels});
+                for (size_t level = 0; level < item->mips.levels.size(); ++level)
+                {
+                    const auto &mip = item->mips.levels[level];
+                    item->levels.push_back({mip.width, mip.height, item->mips.getLevelData(level)});
+                }
+                if (!entry.empty())
+                {
+                    cook(*item, entry, system);
+                }
+            }
+        }
+        item->decoded.store(true, std::memory_order_release); });
+
+    return texture;
+}
+
+void Core::GL::TextureLoader::update()
+{
+    if (pending.empty())
+    {
+        return;
+    }
+    CORE_PROFILE_ZONE("TextureLoader::update");
+
+    std::span<std::byte> window = staging.beginFrame();
+    size_t used = 0;
+
+    staging.bind();
+    for (auto it = pending.begin(); it != pending.end();)
+    {
+        Pending &item = **it;
+        if (!item.decoded.load(std::memory_order_acquire))
+        {
+            ++it;
+            continue;
+        }
+        if (item.levels.empty())
+        {
+            // Decode failed, the placeholder stays
+            it = pending.erase(it);
+            continue;
+        }
+
+        if (!item.texture)
+        {
+            glCreateTextures(GL_TEXTURE_2D, 1, &item.texture);
+            glTextureStorage2D(item.texture, static_cast<GLsizei>(item.levels.size()), GL_RGBA8, item.width, item.height);
+            glTextureParameteri(item.texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTextureParameteri(item.texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTextureParameteri(item.texture, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTextureParameteri(item.texture, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        }
+
+        int levelCount = static_cast<int>(item.levels.size());
+        while (item.uploadedLevel < levelCount)
+        {
+            int level = item.uploadedLevel;
+            int levelWidth = item.levels[level].width;
+            int levelHeight = item.levels[level].height;
+            const unsigned char *levelData = item.levels[level].data;
+
+            size_t rowBytes = static_cast<size_t>(levelWidth) * 4;
+            const unsigned char *source = levelData + static_cast<size_t>(item.uploadedRows) * rowBytes;
+            int rows = levelHeight - item.uploadedRows;
+
+            if (rowBytes > window.size())
+            {
+                // A single row does not fit the staging region, upload from client memory
+                staging.unbind();
+                glTextureSubImage2D(item.texture, level, 0, item.uploadedRows, levelWidth, rows, GL_RGBA, GL_UNSIGNED_BYTE, source);
+                staging.bind();
+            }
+            else
+            {
+                rows = std::min<int>(rows, static_cast<int>((window.size() - used) / rowBytes));
+                if (rows == 0)
+                {
+                    // Frame budget spent, the rest goes out next frame
+                    break;
+                }
+
+                std::memcpy(window.data() + used, source, rows * rowBytes);
+                glTextureSubImage2D(item.texture, level, 0, item.uploadedRows, levelWidth, rows, GL_RGBA, GL_UNSIGNED_BYTE,
+                                    reinterpret_cast<const void *>(staging.getRegionOffset() + used));
+                used += rows * rowBytes;
+            }
+
+            GLState::current().onUpload(rows * rowBytes);
+            item.uploadedRows += rows;
+            if (item.uploadedRows == levelHeight)
+            {
+                ++item.uploadedLevel;
+                item.uploadedRows = 0;
+            }
+        }
+
+        if (item.uploadedLevel < levelCount)
+        {
+            // Only an exhausted budget leaves a level unfinished
+            break;
+        }
+
+        item.target->replace(item.texture, item.width, item.height, item.channels);
+        item.texture = 0;
+        it = pending.erase(it);
+    }
+    staging.unbind();
+
+    staging.endFrame();
+}
+
+std::string Core::GL::TextureLoader::entryPath(const std::string &filePath, ColorSpace colorSpace) const
+{
+    // The same image cooked for both colour spaces keeps two entries
+    char name[40];
+    std::snprintf(name, sizeof(name), "%016llx%s.texture", static_cast<unsigned long long>(fnv1a(filePath)),
+                  colorSpace == ColorSpace::Linear ? "-linear" : "");
+    return (std::filesystem::path(cacheDirectory) / name).string();
+}
+
+bool Core::GL::TextureLoader::loadCooked(Pending &item, const std::string &entry, JobSystem &jobs)
+{
+    CORE_TRACE_ZONE("TextureLoader::loadCooked");
+    CookedFile file;
+    if (!std::filesystem::exists(entry) || file.open(entry, textureMagic, textureVersion))
+    {
+        return false;
+    }
+    auto sources = file.getSourcePaths();
+    if (sources.size() != 1 || sources.front() != item.path || !file.isCurrent(jobs))
+    {
+        return false;
+    }
+
+    auto info = file.getSection<TextureInfo>(Info);
+    auto base = file.getSection<unsigned char>(Base);
+    auto mipLevels = file.getSection<MipChain::Level>(MipLevels);
+    auto mipData = file.getSection<unsigned char>(MipData);
+    if (info.size() != 1 || info[0].width <= 0 || info[0].height <= 0 || info[0].colorSpace != static_cast<int32_t>(item.colorSpace) ||
+        base.size() != static_cast<size_t>(info[0].width) * info[0].height * 4 ||
+        mipLevels.size() + 1 != static_cast<size_t>(mipLevelCount(info[0].width, info[0].height)))
+    {
+        return false;
+    }
+
+    std::vector<Level> levels{{info[0].width, info[0].height, base.data()}};
+    for (const auto &mip : mipLevels)
+    {
+        size_t size = static_cast<size_t>(mip.width) * mip.height * 4;
+        if (mip.width <= 0 || mip.height <= 0 || mip.offset > mipData.size() || size > mipData.size() - mip.offset)
+        {
+            return false;
+        }
+        levels.push_back({mip.width, mip.height, mipData.data() + mip.offset});
+    }
+
+    item.width = info[0].width;
+    item.height = info[0].height;
+    item.channels = info[0].channels;
+    item.levels = std::move(levels);
+    item.cooked = std::move(file);
+    return true;
+}
+
+void Core::GL::TextureLoader::cook(const Pending &item, const std::string &entry, JobSystem &jobs)
+{
+    CORE_TRACE_ZONE("TextureLoader::cook");
+    TextureInfo info{item.width, item.height, item.channels, static_cast<int32_t>(item.colorSpace)};
+    size_t baseSize = static_cast<size_t>(item.width) * item.height * 4;
+
+    CookedFile::Writer writer(textureMagic, textureVersion, {item.path});
+    writer.addSection(Info, std::span<const TextureInfo>(&info, 1));
+    writer.addSection(Base, std::span<const unsigned char>(item.pixels, baseSize));
+    writer.addSection(MipLevels, std::span<const MipChain::Level>(item.mips.levels));
+    writer.addSection(MipData, std::span<const unsigned char>(item.mips.data));
+    if (auto error = writer.write(entry, jobs); error)
+    {
+        std::cerr << "Texture cache: " << *error << '\n';
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../CookedFile.hpp"
+#include "../JobSystem.hpp"
+#include "GLStreamBuffer.hpp"
+#include "GLTexture.hpp"
+#include "Mipmap.hpp"
+
+namespace Core::GL
+{
+    // Loads textures without stalling the render thread. Images are decoded
+    // and their mip chains built on the job system; update() then streams
+    // every level into immutable storage through a persistently mapped
+    // pixel-unpack buffer a few rows at a time, within a per-frame byte
+    // budget. Returned textures show a placeholder texel until the real image
+    // is fully resident, at which point it is swapped in. Given a cache
+    // directory, every decoded image and its mip chain are also cooked to a
+    // file there, and later loads of an unchanged image map that file and
+    // stream the levels straight from it instead of decoding and filtering.
+    class TextureLoader
+    {
+    private:
+        struct Level
+        {
+            int width;
+            int height;
+            const unsigned char *data;
+        };
+
+        struct Pending
+        {
+            std::string path;
+            std::shared_ptr<GLTexture> target;
+            ColorSpace colorSpace = ColorSpace::Srgb;
+            std::atomic<bool> decoded{false};
+            unsigned char *pixels = nullptr;
+            int width = 0;
+            int height = 0;
+            int channels = 0;
+            MipChain mips;
+            CookedFile cooked;
+            // Every level including the base, into pixels and mips or cooked
+            std::vector<Level> levels;
+            GLuint texture = 0;
+            int uploadedLevel = 0;
+            int uploadedRows = 0;
+
+            ~Pending();
+        };
+
+        JobSystem &jobs;
+        std::string cacheDirectory;
+        GLStreamBuffer staging;
+        std::vector<std::shared_ptr<Pending>> pending;
+
+    public:
+        // The staging buffer is allocated up front, so this needs a current
+        // context. An empty cache directory disables cooking.
+        explicit TextureLoader(size_t uploadBytesPerFrame = 16 * 1024 * 1024, JobSystem &jobSystem = JobSystem::shared(),
+                               std::string cookedCacheDirectory = {});
+        ~TextureLoader();
+
+        TextureLoader(const TextureLoader &) = delete;
+        TextureLoader &operator=(const TextureLoader &) = delete;
+
+        // Linear images, such as normal maps, get their mips filtered as stored
+        std::shared_ptr<GLTexture> loadAsync(const std::string &filePath, ColorSpace colorSpace = ColorSpace::Srgb);
+
+        // Call once per frame on the GL thread
+        void update();
+
+        [[nodiscard]] size_t getPendingCount() const noexcept { return pending.size(); }
+
+    private:
+        std::string entryPath(const std::string &filePath, ColorSpace colorSpace) const;
+        // Both run on the job system
+        static bool loadCooked(Pending &item, const std::string &entry, JobSystem &jobs);
+        static void cook(const Pending &item, const std::string &entry, JobSystem &jobs);
+    };
+}
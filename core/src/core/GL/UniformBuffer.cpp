@@ -0,0 +1,51 @@
+#include "UniformBuffer.hpp"
+
+#include <algorithm>
+
+void Core::GL::UniformBuffer::beginFrame(size_t minimumBytes)
+{
+    if (!alignment)
+    {
+        GLint offsetAlignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+        alignment = static_cast<size_t>(std::max(offsetAlignment, 1));
+    }
+
+    if (!stream || minimumBytes > stream->getRegionSize())
+    {
+        // Grow geometrically so a slowly rising demand does not reallocate
+        // every frame. Draws still reading the old buffer keep it alive.
+        while (bytesPerFrame < minimumBytes)
+        {
+            bytesPerFrame *= 2;
+        }
+        stream = std::make_unique<GLStreamBuffer>(BufferType::Uniform, bytesPerFrame);
+    }
+
+    region = stream->beginFrame();
+    head = 0;
+}
+
+void Core::GL::UniformBuffer::endFrame()
+{
+    if (stream)
+    {
+        stream->endFrame();
+    }
+}
+
+std::optional<Core::GL::UniformBuffer::Range> Core::GL::UniformBuffer::allocate(size_t size)
+{
+    size_t aligned = alignedSize(size);
+    if (size == 0 || head + aligned > region.size())
+    {
+        return std::nullopt;
+    }
+
+    Range range;
+    range.offset = static_cast<GLintptr>(stream->getRegionOffset() + head);
+    range.size = static_cast<GLsizeiptr>(size);
+    range.data = region.data() + head;
+    head += aligned;
+    return range;
+}
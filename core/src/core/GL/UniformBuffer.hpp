@@ -0,0 +1,135 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <glm/glm.hpp>
+
+#include "GLShader.hpp"
+#include "GLStreamBuffer.hpp"
+
+namespace Core::GL
+{
+    // Binding points shared by every shader. Blocks pick theirs with
+    // layout(std140, binding = ...), or GLShader::setBlockBinding.
+    enum class UniformBinding : GLuint
+    {
+        Frame = 0,
+        Material = 1,
+        Object = 2
+    };
+
+    // Uniform block data for a frame, packed into one large persistently
+    // mapped uniform buffer. Each frame takes the next region of the
+    // underlying GLStreamBuffer and hands out ranges from it at the driver's
+    // offset alignment, so a draw switches its block data with a single
+    // glBindBufferRange instead of a run of glUniform* calls. GL objects are
+    // created by the first beginFrame, which also grows the buffer when a
+    // frame needs more than it holds.
+    class UniformBuffer
+    {
+    public:
+        struct Range
+        {
+            GLintptr offset = 0;
+            GLsizeiptr size = 0;
+            std::byte *data = nullptr;
+        };
+
+    private:
+        std::unique_ptr<GLStreamBuffer> stream;
+        size_t bytesPerFrame;
+        size_t alignment = 0;
+        std::span<std::byte> region;
+        size_t head = 0;
+
+    public:
+        explicit UniformBuffer(size_t initialBytesPerFrame = 64 * 1024)
+            : bytesPerFrame(initialBytesPerFrame < 256 ? 256 : initialBytesPerFrame)
+        {
+        }
+
+        // The following prevents copying, but allows moving
+        UniformBuffer(const UniformBuffer &) = delete;
+        UniformBuffer &operator=(const UniformBuffer &) = delete;
+        UniformBuffer(UniformBuffer &&other) noexcept = default;
+        UniformBuffer &operator=(UniformBuffer &&other) noexcept = default;
+
+        // Starts writing the next region, replacing the buffer with a larger
+        // one first if a region holds less than minimumBytes
+        void beginFrame(size_t minimumBytes = 0);
+
+        // Call after the draws reading this frame's ranges have been issued
+        void endFrame();
+
+        // Space for one block's data, or nothing once the frame is full
+        [[nodiscard]] std::optional<Range> allocate(size_t size);
+
+        // Allocates and fills a range with a block laid out as a C++ struct
+        template <typename T>
+        [[nodiscard]] std::optional<Range> push(const T &value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            auto range = allocate(sizeof(T));
+            if (range)
+            {
+                std::memcpy(range->data, &value, sizeof(T));
+            }
+            return range;
+        }
+
+        void bind(UniformBinding binding, const Range &range) const
+        {
+            bind(static_cast<GLuint>(binding), range);
+        }
+
+        void bind(GLuint binding, const Range &range) const
+        {
+            GLState::current().bindBufferRange(GL_UNIFORM_BUFFER, binding, stream->getID(), range.offset, range.size);
+        }
+
+        // Writes one member at its reflected offset, element picks an array
+        // entry. Matrices are written column by column at their matrix
+        // stride, so std140 and shared layouts both work.
+        template <typename T>
+        static void write(const Range &range, const GLShader::UniformBlock::Member &member, const T &value, size_t element = 0)
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            size_t offset = static_cast<size_t>(member.offset) + element * static_cast<size_t>(member.arrayStride);
+            if constexpr (std::is_same_v<T, glm::mat4>)
+            {
+                size_t stride = member.matrixStride ? static_cast<size_t>(member.matrixStride) : sizeof(glm::vec4);
+                if (offset + stride * 3 + sizeof(glm::vec4) > static_cast<size_t>(range.size))
+                {
+                    return;
+                }
+                for (int column = 0; column < 4; ++column)
+                {
+                    std::memcpy(range.data + offset + column * stride, &value[column], sizeof(glm::vec4));
+                }
+            }
+            else
+            {
+                if (offset + sizeof(T) > static_cast<size_t>(range.size))
+                {
+                    return;
+                }
+                std::memcpy(range.data + offset, &value, sizeof(T));
+            }
+        }
+
+        // Bytes one allocation of this size really takes
+        [[nodiscard]] size_t alignedSize(size_t size) const noexcept
+        {
+            size_t unit = alignment ? alignment : 256;
+            return (size + unit - 1) / unit * unit;
+        }
+
+        [[nodiscard]] size_t getBytesPerFrame() const noexcept { return bytesPerFrame; }
+        [[nodiscard]] size_t getBytesUsed() const noexcept { return head; }
+    };
+}
@@ -1,8 +1,11 @@
+#pragma once
+
 #include <memory>
 #include <optional>
 #include <functional>
 #include <glad/glad.h>
 #include "GLBuffer.hpp"
+#include "GLState.hpp"
 
 namespace Core::GL
 {
@@ -17,49 +20,93 @@ namespace Core::GL
         VAO()
             : vaoID(std::make_unique<GLuint>(0))
         {
-            glGenVertexArrays(1, vaoID.get());
+            glCreateVertexArrays(1, vaoID.get());
+        }
+
+        // The following prevents copying, but allows moving
+        VAO(const VAO &) = delete;
+        VAO &operator=(const VAO &) = delete;
+        VAO(VAO &&other) noexcept = default;
+        VAO &operator=(VAO &&other) noexcept
+        {
+            if (this != &other)
+            {
+                if (vaoID)
+                {
+                    GLState::current().onVertexArrayDeleted(*vaoID);
+                    glDeleteVertexArrays(1, vaoID.get());
+                }
+                vaoID = std::move(other.vaoID);
+                ebo = std::move(other.ebo);
+            }
+            return *this;
         }
 
         ~VAO()
         {
             if (vaoID)
             {
+                GLState::current().onVertexArrayDeleted(*vaoID);
                 glDeleteVertexArrays(1, vaoID.get());
             }
         }
 
         void bind() const
         {
-            glBindVertexArray(*vaoID);
+            GLState::current().bindVertexArray(*vaoID);
         }
 
         void unbind() const
         {
-            glBindVertexArray(0);
+            GLState::current().bindVertexArray(0);
         }
 
+        // Each attribute gets its own buffer binding point with the same
+        // index. A stride of zero means tightly packed, as with
+        // glVertexAttribPointer. The shader always sees floats: integer
+        // types are converted by the vertex fetch, normalized ones to
+        // [0, 1] or [-1, 1], so quantized data needs no CPU-side decode.
         void addVertexBuffer(const GLBuffer &vbo, GLuint attribIndex, GLint componentCount, GLenum type, GLboolean normalized, GLsizei stride, size_t offset)
         {
-            bind();
-            vbo.bind();
-            glEnableVertexAttribArray(attribIndex);
-            glVertexAttribPointer(attribIndex, componentCount, type, normalized, stride, reinterpret_cast<const void *>(offset));
-            vbo.unbind();
-            unbind();
+            if (stride == 0)
+            {
+                stride = componentCount * componentSize(type);
+            }
+            glVertexArrayVertexBuffer(*vaoID, attribIndex, vbo.getID(), static_cast<GLintptr>(offset), stride);
+            glVertexArrayAttribFormat(*vaoID, attribIndex, componentCount, type, normalized, 0);
+            glVertexArrayAttribBinding(*vaoID, attribIndex, attribIndex);
+            glEnableVertexArrayAttrib(*vaoID, attribIndex);
         }
 
         void setIndexBuffer(const GLBuffer &eboBuffer)
         {
-            bind();
-            eboBuffer.bind();
+            glVertexArrayElementBuffer(*vaoID, eboBuffer.getID());
             ebo = eboBuffer;
-            bind();
         }
 
         GLuint getID() const
         {
             return *vaoID;
         }
+
+    private:
+        static GLsizei componentSize(GLenum type) noexcept
+        {
+            switch (type)
+            {
+            case GL_BYTE:
+            case GL_UNSIGNED_BYTE:
+                return 1;
+            case GL_SHORT:
+            case GL_UNSIGNED_SHORT:
+            case GL_HALF_FLOAT:
+                return 2;
+            case GL_DOUBLE:
+                return 8;
+            default:
+                return 4;
+            }
+        }
     };
 
 }
\ No newline at end of file
@@ -0,0 +1,254 @@
+#include "Accessor.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace
+{
+    // Elements per job, large enough to amortize scheduling
+    constexpr size_t decodeGrainSize = 16 * 1024;
+
+    template <typename T>
+    T load(const std::byte *source) noexcept
+    {
+        T value;
+        std::memcpy(&value, source, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    float toFloat(const std::byte *source, bool normalized) noexcept
+    {
+        T value = load<T>(source);
+        if (!normalized)
+        {
+            return static_cast<float>(value);
+        }
+        if constexpr (std::is_signed_v<T>)
+        {
+            return std::max(static_cast<float>(value) / static_cast<float>(std::numeric_limits<T>::max()), -1.0f);
+        }
+        else
+        {
+            return static_cast<float>(value) / static_cast<float>(std::numeric_limits<T>::max());
+        }
+    }
+
+    template <typename T>
+    void convertRange(const std::byte *source, size_t stride, uint32_t components, bool normalized,
+                      float *out, size_t begin, size_t end) noexcept
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            const std::byte *element = source + i * stride;
+            float *target = out + i * components;
+            for (uint32_t c = 0; c < components; ++c)
+            {
+                target[c] = toFloat<T>(element + c * sizeof(T), normalized);
+            }
+        }
+    }
+
+    template <typename T, typename Out>
+    void widenRange(const std::byte *source, size_t stride, Out *out, size_t begin, size_t end) noexcept
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            out[i] = load<T>(source + i * stride);
+        }
+    }
+
+    void applySparse(const Core::GLTF::Document &document, const Core::GLTF::Accessor &info, std::span<float> out)
+    {
+        const auto &sparse = *info.sparse;
+        const std::byte *indices = document.getBufferViewData(sparse.indicesView).data() + sparse.indicesOffset;
+        const std::byte *values = document.getBufferViewData(sparse.valuesView).data() + sparse.valuesOffset;
+
+        // Substitutions are few, a single thread is plenty
+        for (size_t i = 0; i < sparse.count; ++i)
+        {
+            size_t target;
+            switch (sparse.indicesType)
+            {
+            case GL_UNSIGNED_BYTE:
+                target = load<uint8_t>(indices + i);
+                break;
+            case GL_UNSIGNED_SHORT:
+                target = load<uint16_t>(indices + i * 2);
+                break;
+            default:
+                target = load<uint32_t>(indices + i * 4);
+                break;
+            }
+            if (target >= info.count)
+            {
+                continue;
+            }
+
+            const std::byte *element = values + i * info.elementSize();
+            float *destination = out.data() + target * info.components;
+            switch (info.componentType)
+            {
+            case GL_BYTE:
+                convertRange<int8_t>(element, 0, info.components, info.normalized, destination, 0, 1);
+                break;
+            case GL_UNSIGNED_BYTE:
+                convertRange<uint8_t>(element, 0, info.components, info.normalized, destination, 0, 1);
+                break;
+            case GL_SHORT:
+                convertRange<int16_t>(element, 0, info.components, info.normalized, destination, 0, 1);
+                break;
+            case GL_UNSIGNED_SHORT:
+                convertRange<uint16_t>(element, 0, info.components, info.normalized, destination, 0, 1);
+                break;
+            case GL_UNSIGNED_INT:
+                convertRange<uint32_t>(element, 0, info.components, info.normalized, destination, 0, 1);
+                break;
+            default:
+                convertRange<float>(element, 0, info.components, false, destination, 0, 1);
+                break;
+            }
+        }
+    }
+
+    template <typename Out>
+    std::optional<std::string> copyIndices(const Core::GLTF::Document &document, uint32_t accessor, std::span<Out> out, Core::JobSystem &jobs)
+    {
+        const auto &info = document.getAccessors()[accessor];
+        if (out.size() < info.count)
+        {
+            return std::string("Accessor decode target is too small");
+        }
+        if (info.components != 1 || (info.componentType != GL_UNSIGNED_BYTE && info.componentType != GL_UNSIGNED_SHORT && info.componentType != GL_UNSIGNED_INT))
+        {
+            return std::string("Index accessor must be unsigned scalar");
+        }
+        if (sizeof(Out) < 4 && info.componentType == GL_UNSIGNED_INT)
+        {
+            return std::string("Index accessor does not fit 16 bits");
+        }
+
+        auto data = document.getAccessorData(accessor);
+        if (data.empty())
+        {
+            return std::string("Index accessor has no data");
+        }
+
+        const std::byte *source = data.data();
+        size_t stride = document.getAccessorStride(accessor);
+        GLenum componentType = info.componentType;
+
+        jobs.parallelFor(info.count, decodeGrainSize, [&](size_t begin, size_t end)
+                         {
+            switch (componentType)
+            {
+            case GL_UNSIGNED_BYTE:
+                widenRange<uint8_t>(source, stride, out.data(), begin, end);
+                break;
+            case GL_UNSIGNED_SHORT:
+                widenRange<uint16_t>(source, stride, out.data(), begin, end);
+                break;
+            default:
+                widenRange<uint32_t>(source, stride, out.data(), begin, end);
+                break;
+            } });
+
+        return std::nullopt;
+    }
+}
+
+std::optional<Core::GLTF::VertexFormat> Core::GLTF::getVertexFormat(const Document &document, uint32_t accessor) noexcept
+{
+    const auto &info = document.getAccessors()[accessor];
+    if (info.sparse || !info.bufferView || info.components > 4)
+    {
+        return std::nullopt;
+    }
+    switch (info.componentType)
+    {
+    case GL_FLOAT:
+    case GL_BYTE:
+    case GL_UNSIGNED_BYTE:
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+        break;
+    default:
+        return std::nullopt;
+    }
+
+    // glTF aligns vertex attributes to 4 bytes, anything else, like packed
+    // 3-byte colours, is converted rather than fetched unaligned
+    size_t stride = document.getAccessorStride(accessor);
+    if (stride % 4 != 0 || info.byteOffset % 4 != 0)
+    {
+        return std::nullopt;
+    }
+    bool normalized = info.normalized && info.componentType != GL_FLOAT;
+    return VertexFormat{info.componentType, normalized ? GLboolean(GL_TRUE) : GLboolean(GL_FALSE), static_cast<GLsizei>(stride)};
+}
+
+std::optional<std::string> Core::GLTF::decodeFloats(const Document &document, uint32_t accessor, std::span<float> out, JobSystem &jobs)
+{
+    const auto &info = document.getAccessors()[accessor];
+    if (out.size() < info.count * info.components)
+    {
+        return std::string("Accessor decode target is too small");
+    }
+
+    auto data = document.getAccessorData(accessor);
+    if (data.empty())
+    {
+        // Accessors without a buffer view start out as all zeros
+        std::fill_n(out.begin(), info.count * info.components, 0.0f);
+    }
+    else
+    {
+        const std::byte *source = data.data();
+        size_t stride = document.getAccessorStride(accessor);
+        uint32_t components = info.components;
+        bool normalized = info.normalized;
+        GLenum componentType = info.componentType;
+
+        jobs.parallelFor(info.count, decodeGrainSize, [&](size_t begin, size_t end)
+                         {
+            switch (componentType)
+            {
+            case GL_BYTE:
+                convertRange<int8_t>(source, stride, components, normalized, out.data(), begin, end);
+                break;
+            case GL_UNSIGNED_BYTE:
+                convertRange<uint8_t>(source, stride, components, normalized, out.data(), begin, end);
+                break;
+            case GL_SHORT:
+                convertRange<int16_t>(source, stride, components, normalized, out.data(), begin, end);
+                break;
+            case GL_UNSIGNED_SHORT:
+                convertRange<uint16_t>(source, stride, components, normalized, out.data(), begin, end);
+                break;
+            case GL_UNSIGNED_INT:
+                convertRange<uint32_t>(source, stride, components, normalized, out.data(), begin, end);
+                break;
+            default:
+                convertRange<float>(source, stride, components, false, out.data(), begin, end);
+                break;
+            } });
+    }
+
+    if (info.sparse)
+    {
+        applySparse(document, info, out);
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> Core::GLTF::decodeIndices(const Document &document, uint32_t accessor, std::span<uint32_t> out, JobSystem &jobs)
+{
+    return copyIndices(document, accessor, out, jobs);
+}
+
+std::optional<std::string> Core::GLTF::decodeIndices(const Document &document, uint32_t accessor, std::span<uint16_t> out, JobSystem &jobs)
+{
+    return copyIndices(document, accessor, out, jobs);
+}
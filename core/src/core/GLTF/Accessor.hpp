@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <optional>
+
+#include "../JobSystem.hpp"
+#include "Document.hpp"
+
+namespace Core::GLTF
+{
+    // How the GL fetches an accessor straight from its buffer view
+    struct VertexFormat
+    {
+        GLenum type;
+        GLboolean normalized;
+        GLsizei stride;
+    };
+
+    // Float data, or the 8 and 16-bit integer types KHR_mesh_quantization
+    // allows, which the vertex fetch widens to float itself; nothing when
+    // the accessor has to be converted first, as sparse ones do
+    [[nodiscard]] std::optional<VertexFormat> getVertexFormat(const Document &document, uint32_t accessor) noexcept;
+
+    // Converts any component type to float, applying glTF normalization
+    // rules and removing the buffer view stride. `out` must hold
+    // count * components floats.
+    std::optional<std::string> decodeFloats(const Document &document, uint32_t accessor, std::span<float> out, JobSystem &jobs);
+
+    // Widens uint8/uint16/uint32 indices to uint32. `out` must hold count
+    // values.
+    std::optional<std::string> decodeIndices(const Document &document, uint32_t accessor, std::span<uint32_t> out, JobSystem &jobs);
+
+    // As above into uint16, for uint8 and uint16 accessors
+    std::optional<std::string> decodeIndices(const Document &document, uint32_t accessor, std::span<uint16_t> out, JobSystem &jobs);
+}
@@ -0,0 +1,721 @@
+#include "Document.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../Base64.hpp"
+#include "../JobSystem.hpp"
+#include "../Meshopt.hpp"
+#include "../Trace.hpp"
+
+namespace
+{
+    constexpr uint32_t glbMagic = 0x46546C67; // "glTF"
+    constexpr uint32_t glbChunkJson = 0x4E4F534A;
+    constexpr uint32_t glbChunkBin = 0x004E4942;
+
+    uint32_t readU32(std::span<const std::byte> data, size_t offset)
+    {
+        uint32_t value;
+        std::memcpy(&value, data.data() + offset, sizeof(value));
+        return value;
+    }
+
+    uint32_t componentCount(std::string_view type)
+    {
+        if (type == "SCALAR")
+            return 1;
+        if (type == "VEC2")
+            return 2;
+        if (type == "VEC3")
+            return 3;
+        if (type == "VEC4" || type == "MAT2")
+            return 4;
+        if (type == "MAT3")
+            return 9;
+        if (type == "MAT4")
+            return 16;
+        return 0;
+    }
+
+    // Whether count elements of elementSize bytes, stride bytes apart from
+    // offset, end within length. Divides instead of multiplying so that
+    // huge counts cannot wrap around and pass.
+    bool fitsInView(size_t offset, size_t count, size_t stride, size_t elementSize, size_t length) noexcept
+    {
+        if (count == 0)
+        {
+            return offset <= length;
+        }
+        if (offset > length || elementSize > length - offset)
+        {
+            return false;
+        }
+        return stride == 0 || count - 1 <= (length - offset - elementSize) / stride;
+    }
+}
+
+size_t Core::GLTF::Accessor::componentSize() const noexcept
+{
+    switch (componentType)
+    {
+    case GL_BYTE:
+    case GL_UNSIGNED_BYTE:
+        return 1;
+    case GL_SHORT:
+    case GL_UNSIGNED_SHORT:
+        return 2;
+    case GL_UNSIGNED_INT:
+    case GL_FLOAT:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+std::optional<uint32_t> Core::GLTF::Primitive::findAttribute(std::string_view name) const noexcept
+{
+    for (const auto &attribute : attributes)
+    {
+        if (attribute.name == name)
+        {
+            return attribute.accessor;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> Core::GLTF::Document::loadFromFile(const std::string &filePath)
+{
+    CORE_TRACE_ZONE("Document::loadFromFile");
+    *this = Document();
+    baseDirectory = std::filesystem::path(filePath).parent_path().string();
+
+    MappedFile &file = files.emplace_back();
+    if (auto error = file.open(filePath); error)
+    {
+        return error;
+    }
+    sourcePaths.push_back(filePath);
+
+    std::string_view jsonText;
+    std::span<const std::byte> binChunk;
+    if (auto error = parseContainer(file.getData(), jsonText, binChunk); error)
+    {
+        return error;
+    }
+
+    if (auto error = json.parse(jsonText); error)
+    {
+        return filePath + ": " + *error;
+    }
+
+    if (!json.getRoot().isObject())
+    {
+        return filePath + ": glTF root is not an object";
+    }
+
+    std::optional<std::string> error = parseBuffers(binChunk);
+    error = error ? error : parseBufferViews();
+    error = error ? error : decodeCompressedViews();
+    error = error ? error : parseAccessors();
+    error = error ? error : parseMaterials();
+    error = error ? error : parseMeshes();
+    error = error ? error : parseNodes();
+    error = error ? error : validate();
+    if (error)
+    {
+        return filePath + ": " + *error;
+    }
+
+    return std::nullopt;
+}
+
+std::optional<std::string> Core::GLTF::Document::parseContainer(std::span<const std::byte> file, std::string_view &jsonText, std::span<const std::byte> &binChunk)
+{
+    if (file.size() < 12 || readU32(file, 0) != glbMagic)
+    {
+        // Plain .gltf, the whole file is JSON
+        jsonText = {reinterpret_cast<const char *>(file.data()), file.size()};
+        return std::nullopt;
+    }
+
+    uint32_t version = readU32(file, 4);
+    size_t length = readU32(file, 8);
+    if (version != 2)
+    {
+        return "Unsupported GLB version " + std::to_string(version);
+    }
+    if (length > file.size())
+    {
+        return std::string("GLB length exceeds file size");
+    }
+
+    size_t offset = 12;
+    while (offset + 8 <= length)
+    {
+        size_t chunkLength = readU32(file, offset);
+        uint32_t chunkType = readU32(file, offset + 4);
+        offset += 8;
+        if (offset + chunkLength > length)
+        {
+            return std::string("GLB chunk exceeds file size");
+        }
+
+        auto chunk = file.subspan(offset, chunkLength);
+        if (chunkType == glbChunkJson && jsonText.empty())
+        {
+            jsonText = {reinterpret_cast<const char *>(chunk.data()), chunk.size()};
+        }
+        else if (chunkType == glbChunkBin && binChunk.empty())
+        {
+            binChunk = chunk;
+        }
+        // Chunks are 4-byte aligned
+        offset += (chunkLength + 3) & ~size_t(3);
+    }
+
+    if (jsonText.empty())
+    {
+        return std::string("GLB has no JSON chunk");
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> Core::GLTF::Document::parseBuffers(std::span<const std::byte> binChunk)
+{
+    auto root = json.getRoot();
+    for (auto value : root["buffers"])
+    {
+        size_t byteLength = value["byteLength"].asSize();
+        auto uri = value["uri"];
+
+        // Stands in for the uncompressed data of meshopt compressed views,
+        // which are decoded from another buffer, so it is never loaded
+        if (value["extensions"]["EXT_meshopt_compression"]["fallback"].asBool())
+        {
+            buffers.push_back({});
+            continue;
+        }
+
+        std::span<const std::byte> data;
+        if (!uri)
+        {
+            if (buffers.empty())
+            {
+                data = binChunk;
+            }
+        }
+        else if (uri.asStringView().starts_with("data:"))
+        {
+            // JSON may escape the '/' of the base64 alphabet
+            std::string_view text = uri.asStringView();
+            std::string unescaped;
+            if (text.find('\\') != std::string_view::npos)
+            {
+                unescaped = uri.asString();
+                text = unescaped;
+            }
+            if (auto error = decodeDataUri(text, data); error)
+            {
+                return "Buffer " + std::to_string(buffers.size()) + ": " + *error;
+            }
+        }
+        else
+        {
+            auto path = std::filesystem::path(baseDirectory) / uri.asString();
+            MappedFile &file = files.emplace_back();
+            if (auto error = file.open(path.string()); error)
+            {
+                return error;
+            }
+            sourcePaths.push_back(path.string());
+            data = file.getData();
+        }
+
+        if (data.size() < byteLength)
+        {
+            return "Buffer " + std::to_string(buffers.size()) + " is shorter than its byteLength";
+        }
+        buffers.push_back({data.first(byteLength)});
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> Core::GLTF::Document::decodeDataUri(std::string_view uri, std::span<const std::byte> &data)
+{
+    // data:[<media type>][;base64],<data>
+    size_t comma = uri.find(',');
+    if (comma == std::string_view::npos || !uri.substr(0, comma).ends_with(";base64"))
+    {
+        return std::string("Only base64 data URIs are supported");
+    }
+    std::string_view text = uri.substr(comma + 1);
+    auto size = base64DecodedSize(text);
+    if (!size)
+    {
+        return std::string("Data URI has a malformed base64 length");
+    }
+
+    // Left uninitialised, the decoder writes every byte
+    auto &storage = decodedBuffers.emplace_back(std::make_unique_for_overwrite<std::byte[]>(*size));
+    std::span<std::byte> decoded(storage.get(), *size);
+    if (!decodeBase64(text, decoded))
+    {
+        return std::string("Data URI has invalid base64 characters");
+    }
+    data = decoded;
+    return std::nullopt;
+}
+
+std::optional<std::string> Core::GLTF::Document::parseBufferViews()
+{
+    for (auto value : json.getRoot()["bufferViews"])
+    {
+        BufferView view;
+        view.buffer = value["buffer"].asUInt();
+        view.byteOffset = value["byteOffset"].asSize();
+        view.byteLength = value["byteLength"].asSize();
+        view.byteStride = value["byteStride"].asUInt();
+        view.target = value["target"].asUInt();
+
+        // Compressed views are checked against their compressed data instead
+        bool compressed = static_cast<bool>(value["extensions"]["EXT_meshopt_compression"]);
+        if (view.buffer >= buffers.size() ||
+            (!compressed && (view.byteOffset > buffers[view.buffer].data.size() ||
+                             view.byteLength > buffers[view.buffer].data.size() - view.byteOffset)))
+        {
+            return "Buffer view " + std::to_string(bufferViews.size()) + " is out of range";
+        }
+        bufferViews.push_back(view);
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> Core::GLTF::Document::decodeCompressedViews()
+{
+    CORE_TRACE_ZONE("Document::decodeCompressedViews");
+    enum class Mode
+    {
+        Attributes,
+        Triangles,
+        Indices
+    };
+    struct Pending
+    {
+        uint32_t view;
+        Mode mode;
+        MeshoptFilter filter;
+        size_t count;
+        size_t stride;
+        std::span<const std::byte> source;
+        std::span<std::byte> target;
+        std::optional<std::string> error;
+    };
+
+    std::vector<Pending> pending;
+    uint32_t view = 0;
+    for (auto value : json.getRoot()["bufferViews"])
+    {
+        auto compression = value["extensions"]["EXT_meshopt_compression"];
+        if (!compression)
+        {
+            ++view;
+            continue;
+        }
+
+        std::string name = "Buffer view " + std::to_string(view);
+        uint32_t buffer = compression["buffer"].asUInt();
+        size_t byteOffset = compression["byteOffset"].asSize();
+        size_t byteLength = compression["byteLength"].asSize();
+        if (buffer >= buffers.size() || byteOffset > buffers[buffer].data.size() || byteLength > buffers[buffer].data.size() - byteOffset)
+        {
+            return name + " has compressed data out of range";
+        }
+
+        Pending entry{view, Mode::Attributes, MeshoptFilter::None, compression["count"].asSize(),
+                      compression["byteStride"].asSize(), buffers[buffer].data.subspan(byteOffset, byteLength), {}, {}};
+        std::string_view mode = compression["mode"].asStringView();
+        if (mode == "TRIANGLES")
+        {
+            entry.mode = Mode::Triangles;
+        }
+        else if (mode == "INDICES")
+        {
+            entry.mode = Mode::Indices;
+        }
+        else if (mode != "ATTRIBUTES")
+        {
+            return name + " has unknown meshopt mode '" + std::string(mode) + "'";
+        }
+
+        std::string_view filter = compression["filter"].asStringView();
+        if (filter == "OCTAHEDRAL")
+        {
+            entry.filter = MeshoptFilter::Octahedral;
+        }
+        else if (filter == "QUATERNION")
+        {
+            entry.filter = MeshoptFilter::Quaternion;
+        }
+        else if (filter == "EXPONENTIAL")
+        {
+            entry.filter = MeshoptFilter::Exponential;
+        }
+        else if (!filter.empty() && filter != "NONE")
+        {
+            return name + " has unknown meshopt filter '" + std::string(filter) + "'";
+        }
+        if (entry.filter != MeshoptFilter::None && entry.mode != Mode::Attributes)
+        {
+            return name + " has a meshopt filter on index data";
+        }
+
+        if (entry.stride == 0 || entry.count > std::numeric_limits<size_t>::max() / entry.stride)
+        {
+            return name + " has an invalid meshopt count or byteStride";
+        }
+        size_t size = entry.count * entry.stride;
+        if (size != bufferViews[view].byteLength)
+        {
+            return name + " does not decompress to its byteLength";
+        }
+        // Left uninitialised, the decoders write every byte
+        auto &storage = decodedBuffers.emplace_back(std::make_unique_for_overwrite<std::byte[]>(size));
+        entry.target = {storage.get(), size};
+        pending.push_back(entry);
+        ++view;
+    }
+
+    // Each view is one sequential stream, so views are decoded in parallel
+    JobSystem::shared().parallelFor(pending.size(), 1, [&](size_t begin, size_t end)
+                                    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            auto &entry = pending[i];
+            switch (entry.mode)
+            {
+            case Mode::Attributes:
+                entry.error = decodeMeshoptVertices(entry.target, entry.count, entry.stride, entry.source);
+                if (!entry.error)
+                {
+                    entry.error = applyMeshoptFilter(entry.filter, entry.target, entry.count, entry.stride);
+                }
+                break;
+            case Mode::Triangles:
+                entry.error = decodeMeshoptTriangles(entry.target, entry.count, entry.stride, entry.source);
+                break;
+            case Mode::Indices:
+                entry.error = decodeMeshoptIndices(entry.target, entry.count, entry.stride, entry.source);
+                break;
+            }
+        } });
+
+    for (const auto &entry : pending)
+    {
+        if (entry.error)
+        {
+            return "Buffer view " + std::to_string(entry.view) + ": " + *entry.error;
+        }
+        bufferViews[entry.view].decoded = entry.target;
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> Core::GLTF::Document::parseAccessors()
+{
+    for (auto value : json.getRoot()["accessors"])
+    {
+        Accessor accessor;
+        accessor.bufferView = value["bufferView"].asIndex();
+        accessor.byteOffset = value["byteOffset"].asSize();
+        accessor.componentType = value["componentType"].asUInt();
+        accessor.normalized = value["normalized"].asBool();
+        accessor.count = value["count"].asSize();
+        accessor.components = componentCount(value["type"].asStringView());
+        if (auto sparse = value["sparse"]; sparse)
+        {
+            Accessor::Sparse info;
+            info.count = sparse["count"].asSize();
+            info.indicesView = sparse["indices"]["bufferView"].asUInt();
+            info.indicesOffset = sparse["indices"]["byteOffset"].asSize();
+            info.indicesType = sparse["indices"]["componentType"].asUInt();
+            info.valuesView = sparse["values"]["bufferView"].asUInt();
+            info.valuesOffset = sparse["values"]["byteOffset"].asSize();
+            accessor.sparse = info;
+        }
+
+        if (accessor.components == 0 || accessor.componentSize() == 0)
+        {
+            return "Accessor " + std::to_string(accessors.size()) + " has an invalid type";
+        }
+        accessors.push_back(accessor);
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> Core::GLTF::Document::parseMaterials()
+{
+    for (auto value : json.getRoot()["materials"])
+    {
+        Material material;
+        material.name = value["name"].asString();
+        std::string_view alphaMode = value["alphaMode"].asStringView();
+        if (alphaMode == "MASK")
+        {
+            material.alphaMode = Material::AlphaMode::Mask;
+        }
+        else if (alphaMode == "BLEND")
+        {
+            material.alphaMode = Material::AlphaMode::Blend;
+        }
+        material.alphaCutoff = static_cast<float>(value["alphaCutoff"].asNumber(0.5));
+        material.doubleSided = value["doubleSided"].asBool();
+        material.baseColorTexture = value["pbrMetallicRoughness"]["baseColorTexture"]["index"].asIndex();
+        material.normalTexture = value["normalTexture"]["index"].asIndex();
+        materials.push_back(std::move(material));
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> Core::GLTF::Document::parseMeshes()
+{
+    for (auto value : json.getRoot()["meshes"])
+    {
+        Mesh mesh;
+        mesh.name = value["name"].asString();
+        for (auto primitiveValue : value["primitives"])
+        {
+            Primitive primitive;
+            for (auto attribute : primitiveValue["attributes"])
+            {
+                primitive.attributes.push_back({std::string(attribute.key()), attribute.asUInt()});
+            }
+            primitive.indices = primitiveValue["indices"].asIndex();
+            primitive.material = primitiveValue["material"].asIndex();
+            primitive.mode = primitiveValue["mode"].asUInt(GL_TRIANGLES);
+            mesh.primitives.push_back(std::move(primitive));
+        }
+        meshes.push_back(std::move(mesh));
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> Core::GLTF::Document::parseNodes()
+{
+    auto root = json.getRoot();
+    for (auto value : root["nodes"])
+    {
+        Node node;
+        node.name = value["name"].asString();
+        node.mesh = value["mesh"].asIndex();
+        for (auto child : value["children"])
+        {
+            node.children.push_back(child.asUInt());
+        }
+
+        if (auto matrix = value["matrix"]; matrix.size() == 16)
+        {
+            for (int i = 0; i < 16; ++i)
+            {
+                node.matrix[i / 4][i % 4] = static_cast<float>(matrix[i].asNumber());
+            }
+        }
+        else
+        {
+            auto t = value["translation"];
+            auto r = value["rotation"];
+            auto s = value["scale"];
+            glm::vec3 translation(t[0].asNumber(), t[1].asNumber(), t[2].asNumber());
+            glm::quat rotation(static_cast<float>(r[3].asNumber(1.0)), static_cast<float>(r[0].asNumber()),
+                               static_cast<float>(r[1].asNumber()), static_cast<float>(r[2].asNumber()));
+            glm::vec3 scale(s[0].asNumber(1.0), s[1].asNumber(1.0), s[2].asNumber(1.0));
+            node.matrix = glm::translate(glm::mat4(1.0f), translation) * glm::mat4_cast(rotation) * glm::scale(glm::mat4(1.0f), scale);
+        }
+        nodes.push_back(std::move(node));
+    }
+
+    for (auto value : root["scenes"])
+    {
+        Scene scene;
+        scene.name = value["name"].asString();
+        for (auto node : value["nodes"])
+        {
+            scene.nodes.push_back(node.asUInt());
+        }
+        scenes.push_back(std::move(scene));
+    }
+    defaultScene = root["scene"].asIndex();
+    return std::nullopt;
+}
+
+std::optional<std::string> Core::GLTF::Document::validate() const
+{
+    for (size_t i = 0; i < accessors.size(); ++i)
+    {
+        const auto &accessor = accessors[i];
+        // Loaders size their output as count times the element size
+        if (accessor.elementSize() != 0 && accessor.count > std::numeric_limits<size_t>::max() / accessor.elementSize())
+        {
+            return "Accessor " + std::to_string(i) + " has too many elements";
+        }
+        if (accessor.sparse)
+        {
+            const auto &sparse = *accessor.sparse;
+            size_t indexSize = sparse.indicesType == GL_UNSIGNED_BYTE ? 1 : sparse.indicesType == GL_UNSIGNED_SHORT ? 2 : 4;
+            if (sparse.indicesView >= bufferViews.size() || sparse.valuesView >= bufferViews.size() ||
+                !fitsInView(sparse.indicesOffset, sparse.count, indexSize, indexSize, bufferViews[sparse.indicesView].byteLength) ||
+                !fitsInView(sparse.valuesOffset, sparse.count, accessor.elementSize(), accessor.elementSize(), bufferViews[sparse.valuesView].byteLength))
+            {
+                return "Sparse accessor " + std::to_string(i) + " is out of range";
+            }
+        }
+        if (!accessor.bufferView || accessor.count == 0)
+        {
+            continue;
+        }
+        if (*accessor.bufferView >= bufferViews.size())
+        {
+            return "Accessor " + std::to_string(i) + " references a missing buffer view";
+        }
+        const auto &view = bufferViews[*accessor.bufferView];
+        size_t stride = view.byteStride ? view.byteStride : accessor.elementSize();
+        if (!fitsInView(accessor.byteOffset, accessor.count, stride, accessor.elementSize(), view.byteLength))
+        {
+            return "Accessor " + std::to_string(i) + " overruns its buffer view";
+        }
+    }
+
+    for (const auto &mesh : meshes)
+    {
+        for (const auto &primitive : mesh.primitives)
+        {
+            for (const auto &attribute : primitive.attributes)
+            {
+                if (attribute.accessor >= accessors.size())
+                {
+                    return "Mesh '" + mesh.name + "' references a missing accessor";
+                }
+            }
+            if (primitive.indices && *primitive.indices >= accessors.size())
+            {
+                return "Mesh '" + mesh.name + "' references a missing index accessor";
+            }
+            if (primitive.material && *primitive.material >= materials.size())
+            {
+                return "Mesh '" + mesh.name + "' references a missing material";
+            }
+        }
+    }
+
+    for (const auto &node : nodes)
+    {
+        if (node.mesh && *node.mesh >= meshes.size())
+        {
+            return "Node '" + node.name + "' references a missing mesh";
+        }
+        for (uint32_t child : node.children)
+        {
+            if (child >= nodes.size())
+            {
+                return "Node '" + node.name + "' references a missing child";
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+std::span<const std::byte> Core::GLTF::Document::getBufferViewData(uint32_t view) const noexcept
+{
+    if (view >= bufferViews.size())
+    {
+        return {};
+    }
+    const auto &bufferView = bufferViews[view];
+    if (bufferView.decoded.data())
+    {
+        return bufferView.decoded;
+    }
+    return buffers[bufferView.buffer].data.subspan(bufferView.byteOffset, bufferView.byteLength);
+}
+
+std::span<const std::byte> Core::GLTF::Document::getAccessorData(uint32_t accessor) const noexcept
+{
+    if (accessor >= accessors.size() || !accessors[accessor].bufferView || accessors[accessor].count == 0)
+    {
+        return {};
+    }
+    const auto &info = accessors[accessor];
+    size_t length = getAccessorStride(accessor) * (info.count - 1) + info.elementSize();
+    return getBufferViewData(*info.bufferView).subspan(info.byteOffset, length);
+}
+
+size_t Core::GLTF::Document::getAccessorStride(uint32_t accessor) const noexcept
+{
+    const auto &info = accessors[accessor];
+    if (info.bufferView && bufferViews[*info.bufferView].byteStride)
+    {
+        return bufferViews[*info.bufferView].byteStride;
+    }
+    return info.elementSize();
+}
+
+std::vector<std::pair<uint32_t, glm::mat4>> Core::GLTF::Document::getNodeWorldTransforms() const
+{
+    std::vector<std::pair<uint32_t, glm::mat4>> result;
+    std::vector<std::pair<uint32_t, glm::mat4>> stack;
+
+    if (scenes.empty())
+    {
+        // No scene, every node without a parent is a root
+        std::vector<bool> isChild(nodes.size(), false);
+        for (const auto &node : nodes)
+        {
+            for (uint32_t child : node.children)
+            {
+                isChild[child] = true;
+            }
+        }
+        for (uint32_t i = 0; i < nodes.size(); ++i)
+        {
+            if (!isChild[i])
+            {
+                stack.emplace_back(i, glm::mat4(1.0f));
+            }
+        }
+    }
+    else
+    {
+        const auto &scene = scenes[defaultScene.value_or(0) < scenes.size() ? defaultScene.value_or(0) : 0];
+        for (uint32_t root : scene.nodes)
+        {
+            if (root < nodes.size())
+            {
+                stack.emplace_back(root, glm::mat4(1.0f));
+            }
+        }
+    }
+
+    std::vector<bool> visited(nodes.size(), false);
+    while (!stack.empty())
+    {
+        auto [index, parent] = stack.back();
+        stack.pop_back();
+        if (visited[index])
+        {
+            continue;
+        }
+        visited[index] = true;
+
+        glm::mat4 world = parent * nodes[index].matrix;
+        result.emplace_back(index, world);
+        for (uint32_t child : nodes[index].children)
+        {
+            stack.emplace_back(child, world);
+        }
+    }
+    return result;
+}
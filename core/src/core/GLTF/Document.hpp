@@ -0,0 +1,180 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+#include <optional>
+#include <glm/glm.hpp>
+
+#include "../MappedFile.hpp"
+#include "Json.hpp"
+
+namespace Core::GLTF
+{
+    struct Buffer
+    {
+        std::span<const std::byte> data;
+    };
+
+    struct BufferView
+    {
+        uint32_t buffer = 0;
+        size_t byteOffset = 0;
+        size_t byteLength = 0;
+        uint32_t byteStride = 0;
+        GLenum target = 0;
+        // EXT_meshopt_compression views are decoded at load; the data then
+        // lives here instead of in the buffer, which may be a placeholder
+        std::span<const std::byte> decoded;
+    };
+
+    struct Accessor
+    {
+        // Element substitutions applied on top of the base data
+        struct Sparse
+        {
+            size_t count = 0;
+            uint32_t indicesView = 0;
+            size_t indicesOffset = 0;
+            GLenum indicesType = GL_UNSIGNED_INT;
+            uint32_t valuesView = 0;
+            size_t valuesOffset = 0;
+        };
+
+        std::optional<uint32_t> bufferView;
+        size_t byteOffset = 0;
+        GLenum componentType = GL_FLOAT;
+        bool normalized = false;
+        size_t count = 0;
+        uint32_t components = 1;
+        std::optional<Sparse> sparse;
+
+        [[nodiscard]] size_t componentSize() const noexcept;
+        [[nodiscard]] size_t elementSize() const noexcept { return componentSize() * components; }
+    };
+
+    struct Primitive
+    {
+        struct Attribute
+        {
+            std::string name;
+            uint32_t accessor;
+        };
+
+        std::vector<Attribute> attributes;
+        std::optional<uint32_t> indices;
+        std::optional<uint32_t> material;
+        GLenum mode = GL_TRIANGLES;
+
+        [[nodiscard]] std::optional<uint32_t> findAttribute(std::string_view name) const noexcept;
+    };
+
+    // The parts of a material that decide which shader variant draws it
+    struct Material
+    {
+        enum class AlphaMode
+        {
+            Opaque,
+            Mask,
+            Blend
+        };
+
+        std::string name;
+        AlphaMode alphaMode = AlphaMode::Opaque;
+        float alphaCutoff = 0.5f;
+        bool doubleSided = false;
+        std::optional<uint32_t> baseColorTexture;
+        std::optional<uint32_t> normalTexture;
+    };
+
+    struct Mesh
+    {
+        std::string name;
+        std::vector<Primitive> primitives;
+    };
+
+    struct Node
+    {
+        std::string name;
+        std::optional<uint32_t> mesh;
+        std::vector<uint32_t> children;
+        glm::mat4 matrix{1.0f};
+    };
+
+    struct Scene
+    {
+        std::string name;
+        std::vector<uint32_t> nodes;
+    };
+
+    // Parsed .glb or .gltf file. Buffer data is never copied: buffers are
+    // views into memory mapped files owned by the document, or for data
+    // URIs and meshopt compressed buffer views into the memory they were
+    // decoded into once at load, so spans returned from here stay valid
+    // until the document is destroyed.
+    class Document
+    {
+    private:
+        std::vector<MappedFile> files;
+        std::vector<std::string> sourcePaths;
+        std::vector<std::unique_ptr<std::byte[]>> decodedBuffers;
+        Json json;
+        std::string baseDirectory;
+
+        std::vector<Buffer> buffers;
+        std::vector<BufferView> bufferViews;
+        std::vector<Accessor> accessors;
+        std::vector<Material> materials;
+        std::vector<Mesh> meshes;
+        std::vector<Node> nodes;
+        std::vector<Scene> scenes;
+        std::optional<uint32_t> defaultScene;
+
+    public:
+        Document() = default;
+
+        // The following prevents copying, but allows moving
+        Document(const Document &) = delete;
+        Document &operator=(const Document &) = delete;
+        Document(Document &&other) noexcept = default;
+        Document &operator=(Document &&other) noexcept = default;
+
+        std::optional<std::string> loadFromFile(const std::string &filePath);
+
+        // Bytes covered by a buffer view, straight out of the mapping
+        [[nodiscard]] std::span<const std::byte> getBufferViewData(uint32_t view) const noexcept;
+        // Bytes from an accessor's first element to the end of its last
+        [[nodiscard]] std::span<const std::byte> getAccessorData(uint32_t accessor) const noexcept;
+        // Distance between elements, falling back to the packed size
+        [[nodiscard]] size_t getAccessorStride(uint32_t accessor) const noexcept;
+
+        // World transforms for every node reachable from the default scene
+        [[nodiscard]] std::vector<std::pair<uint32_t, glm::mat4>> getNodeWorldTransforms() const;
+
+        // The .gltf or .glb first, then every external buffer file
+        [[nodiscard]] const std::vector<std::string> &getSourcePaths() const noexcept { return sourcePaths; }
+        [[nodiscard]] const Json &getJson() const noexcept { return json; }
+        [[nodiscard]] const std::vector<Buffer> &getBuffers() const noexcept { return buffers; }
+        [[nodiscard]] const std::vector<BufferView> &getBufferViews() const noexcept { return bufferViews; }
+        [[nodiscard]] const std::vector<Accessor> &getAccessors() const noexcept { return accessors; }
+        [[nodiscard]] const std::vector<Material> &getMaterials() const noexcept { return materials; }
+        [[nodiscard]] const std::vector<Mesh> &getMeshes() const noexcept { return meshes; }
+        [[nodiscard]] const std::vector<Node> &getNodes() const noexcept { return nodes; }
+        [[nodiscard]] const std::vector<Scene> &getScenes() const noexcept { return scenes; }
+
+    private:
+        std::optional<std::string> parseContainer(std::span<const std::byte> file, std::string_view &jsonText, std::span<const std::byte> &binChunk);
+        std::optional<std::string> parseBuffers(std::span<const std::byte> binChunk);
+        std::optional<std::string> decodeDataUri(std::string_view uri, std::span<const std::byte> &data);
+        std::optional<std::string> parseBufferViews();
+        std::optional<std::string> decodeCompressedViews();
+        std::optional<std::string> parseAccessors();
+        std::optional<std::string> parseMaterials();
+        std::optional<std::string> parseMeshes();
+        std::optional<std::string> parseNodes();
+        std::optional<std::string> validate() const;
+    };
+}
@@ -0,0 +1,779 @@
+#include "Json.hpp"
+
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "../Trace.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#define CORE_JSON_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define CORE_JSON_NEON 1
+#endif
+
+namespace
+{
+    constexpr size_t maxDepth = 512;
+    constexpr size_t blockSize = 64;
+
+    // One bit per byte of a 64-byte block
+    struct BlockMasks
+    {
+        uint64_t whitespace;
+        uint64_t operators; // { } [ ] : ,
+        uint64_t quotes;
+        uint64_t backslashes;
+        uint64_t controls; // below 0x20
+    };
+
+#if defined(CORE_JSON_SSE2)
+    BlockMasks classify(const char *block) noexcept
+    {
+        BlockMasks masks{};
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + lane * 16));
+            auto equals = [&](char c)
+            { return _mm_cmpeq_epi8(bytes, _mm_set1_epi8(c)); };
+            auto bits = [&](__m128i mask)
+            { return static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(mask))) << (lane * 16); };
+
+            // Setting 0x20 folds '[' and ']' onto '{' and '}'
+            __m128i folded = _mm_or_si128(bytes, _mm_set1_epi8(0x20));
+            __m128i brackets = _mm_or_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('{')), _mm_cmpeq_epi8(folded, _mm_set1_epi8('}')));
+            __m128i separators = _mm_or_si128(equals(':'), equals(','));
+            __m128i spaces = _mm_or_si128(_mm_or_si128(equals(' '), equals('\t')), _mm_or_si128(equals('\n'), equals('\r')));
+            __m128i controls = _mm_cmpeq_epi8(_mm_max_epu8(bytes, _mm_set1_epi8(0x1F)), _mm_set1_epi8(0x1F));
+
+            masks.whitespace |= bits(spaces);
+            masks.operators |= bits(_mm_or_si128(brackets, separators));
+            masks.quotes |= bits(equals('"'));
+            masks.backslashes |= bits(equals('\\'));
+            masks.controls |= bits(controls);
+        }
+        return masks;
+    }
+#elif defined(CORE_JSON_NEON)
+    uint64_t toBitmask(uint8x16_t m0, uint8x16_t m1, uint8x16_t m2, uint8x16_t m3) noexcept
+    {
+        const uint8x16_t weights = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+        uint8x16_t sum0 = vpaddq_u8(vandq_u8(m0, weights), vandq_u8(m1, weights));
+        uint8x16_t sum1 = vpaddq_u8(vandq_u8(m2, weights), vandq_u8(m3, weights));
+        sum0 = vpaddq_u8(sum0, sum1);
+        sum0 = vpaddq_u8(sum0, sum0);
+        return vgetq_lane_u64(vreinterpretq_u64_u8(sum0), 0);
+    }
+
+    BlockMasks classify(const char *block) noexcept
+    {
+        uint8x16_t bytes[4];
+        for (int lane = 0; lane < 4; ++lane)
+        {
+            bytes[lane] = vld1q_u8(reinterpret_cast<const uint8_t *>(block + lane * 16));
+        }
+        auto mask = [&](auto test)
+        { return toBitmask(test(bytes[0]), test(bytes[1]), test(bytes[2]), test(bytes[3])); };
+
+        BlockMasks masks;
+        masks.whitespace = mask([](uint8x16_t b)
+                                { return vorrq_u8(vorrq_u8(vceqq_u8(b, vdupq_n_u8(' ')), vceqq_u8(b, vdupq_n_u8('\t'))),
+                                                  vorrq_u8(vceqq_u8(b, vdupq_n_u8('\n')), vceqq_u8(b, vdupq_n_u8('\r')))); });
+        masks.operators = mask([](uint8x16_t b)
+                               {
+                                   uint8x16_t folded = vorrq_u8(b, vdupq_n_u8(0x20));
+                                   return vorrq_u8(vorrq_u8(vceqq_u8(folded, vdupq_n_u8('{')), vceqq_u8(folded, vdupq_n_u8('}'))),
+                                                   vorrq_u8(vceqq_u8(b, vdupq_n_u8(':')), vceqq_u8(b, vdupq_n_u8(',')))); });
+        masks.quotes = mask([](uint8x16_t b)
+                            { return vceqq_u8(b, vdupq_n_u8('"')); });
+        masks.backslashes = mask([](uint8x16_t b)
+                                 { return vceqq_u8(b, vdupq_n_u8('\\')); });
+        masks.controls = mask([](uint8x16_t b)
+                              { return vcltq_u8(b, vdupq_n_u8(0x20)); });
+        return masks;
+    }
+#else
+    BlockMasks classify(const char *block) noexcept
+    {
+        BlockMasks masks{};
+        for (size_t i = 0; i < blockSize; ++i)
+        {
+            unsigned char c = static_cast<unsigned char>(block[i]);
+            uint64_t bit = uint64_t(1) << i;
+            char folded = static_cast<char>(c | 0x20);
+            masks.whitespace |= (c == ' ' || c == '\t' || c == '\n' || c == '\r') ? bit : 0;
+            masks.operators |= (folded == '{' || folded == '}' || c == ':' || c == ',') ? bit : 0;
+            masks.quotes |= c == '"' ? bit : 0;
+            masks.backslashes |= c == '\\' ? bit : 0;
+            masks.controls |= c < 0x20 ? bit : 0;
+        }
+        return masks;
+    }
+#endif
+
+    // Bit i becomes the XOR of bits 0..i, turning quote positions into a
+    // mask of everything from an opening quote up to its closing quote
+    uint64_t prefixXor(uint64_t bits) noexcept
+    {
+        bits ^= bits << 1;
+        bits ^= bits << 2;
+        bits ^= bits << 4;
+        bits ^= bits << 8;
+        bits ^= bits << 16;
+        bits ^= bits << 32;
+        return bits;
+    }
+
+    // Characters escaped by a backslash. Backslashes are rare in glTF, so
+    // the runs are walked one bit at a time instead of with carry tricks.
+    // carry is set when the block ends in an unpaired backslash.
+    uint64_t findEscaped(uint64_t backslashes, uint64_t &carry) noexcept
+    {
+        uint64_t escaped = carry;
+        carry = 0;
+        backslashes &= ~escaped;
+        while (backslashes)
+        {
+            int bit = std::countr_zero(backslashes);
+            backslashes &= backslashes - 1;
+            if (bit == 63)
+            {
+                carry = 1;
+                break;
+            }
+            uint64_t next = uint64_t(1) << (bit + 1);
+            escaped |= next;
+            backslashes &= ~next;
+        }
+        return escaped;
+    }
+
+    // Bytes that end a number or literal
+    constexpr std::array<bool, 256> scalarEnds = []
+    {
+        std::array<bool, 256> table{};
+        for (unsigned char c : std::string_view(" \t\n\r,:[]{}\""))
+        {
+            table[c] = true;
+        }
+        return table;
+    }();
+
+    bool isDigit(char c) noexcept
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    // Checks the scalar starting at pos against the JSON grammar for
+    // numbers and the three literals
+    bool isValidScalar(std::string_view text, size_t pos) noexcept
+    {
+        const char *p = text.data() + pos;
+        const char *end = text.data() + text.size();
+        auto endsAt = [&](const char *q)
+        { return q == end || scalarEnds[static_cast<unsigned char>(*q)]; };
+        auto literal = [&](std::string_view word)
+        { return static_cast<size_t>(end - p) >= word.size() && std::string_view(p, word.size()) == word && endsAt(p + word.size()); };
+        auto digits = [&]
+        {
+            const char *start = p;
+            while (p != end && isDigit(*p))
+            {
+                ++p;
+            }
+            return p != start;
+        };
+
+        switch (*p)
+        {
+        case 't':
+            return literal("true");
+        case 'f':
+            return literal("false");
+        case 'n':
+            return literal("null");
+        case '-':
+            ++p;
+            break;
+        default:
+            break;
+        }
+
+        if (p != end && *p == '0')
+        {
+            ++p;
+        }
+        else if (!digits())
+        {
+            return false;
+        }
+        if (p != end && *p == '.')
+        {
+            ++p;
+            if (!digits())
+            {
+                return false;
+            }
+        }
+        if (p != end && (*p == 'e' || *p == 'E'))
+        {
+            ++p;
+            if (p != end && (*p == '+' || *p == '-'))
+            {
+                ++p;
+            }
+            if (!digits())
+            {
+                return false;
+            }
+        }
+        return endsAt(p);
+    }
+
+    // Most glTF numbers are short: indices, counts and floats written with
+    // a handful of digits. A mantissa below 2^53 scaled by a power of ten up
+    // to 10^22 is exact in a double either way, so one multiply or divide
+    // rounds correctly (Clinger's fast path). Anything longer is left to
+    // from_chars.
+    std::optional<double> parseShortNumber(const char *p, const char *end) noexcept
+    {
+        static constexpr double powersOfTen[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                                 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        constexpr uint64_t maxExactMantissa = uint64_t(1) << 53;
+
+        bool negative = *p == '-';
+        p += negative;
+        uint64_t mantissa = 0;
+        int digits = 0;
+        int exponent = 0;
+        for (; p != end && isDigit(*p); ++p, ++digits)
+        {
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+        }
+        if (p != end && *p == '.')
+        {
+            for (++p; p != end && isDigit(*p); ++p, ++digits, --exponent)
+            {
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+            }
+        }
+        if (p != end && (*p == 'e' || *p == 'E'))
+        {
+            ++p;
+            bool negativeExponent = p != end && *p == '-';
+            p += p != end && (*p == '-' || *p == '+');
+            int value = 0;
+            for (int length = 0; p != end && isDigit(*p); ++p, ++length)
+            {
+                if (length == 4)
+                {
+                    return std::nullopt;
+                }
+                value = value * 10 + (*p - '0');
+            }
+            exponent += negativeExponent ? -value : value;
+        }
+
+        // 19 digits cannot overflow the mantissa
+        if (digits > 19 || mantissa > maxExactMantissa || exponent < -22 || exponent > 22)
+        {
+            return std::nullopt;
+        }
+        double number = static_cast<double>(mantissa);
+        number = exponent < 0 ? number / powersOfTen[-exponent] : number * powersOfTen[exponent];
+        return negative ? -number : number;
+    }
+
+    std::string fail(size_t offset, const char *message)
+    {
+        return std::string("JSON parse error at offset ") + std::to_string(offset) + ": " + message;
+    }
+
+    void appendUtf8(std::string &out, uint32_t codepoint)
+    {
+        if (codepoint < 0x80)
+        {
+            out += static_cast<char>(codepoint);
+        }
+        else if (codepoint < 0x800)
+        {
+            out += static_cast<char>(0xC0 | (codepoint >> 6));
+            out += static_cast<char>(0x80 | (codepoint & 0x3F));
+        }
+        else if (codepoint < 0x10000)
+        {
+            out += static_cast<char>(0xE0 | (codepoint >> 12));
+            out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codepoint & 0x3F));
+        }
+        else
+        {
+            out += static_cast<char>(0xF0 | (codepoint >> 18));
+            out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codepoint & 0x3F));
+        }
+    }
+
+    uint32_t parseHex4(std::string_view text, size_t pos)
+    {
+        uint32_t value = 0;
+        if (pos + 4 > text.size() ||
+            std::from_chars(text.data() + pos, text.data() + pos + 4, value, 16).ptr != text.data() + pos + 4)
+        {
+            return 0xFFFD;
+        }
+        return value;
+    }
+}
+
+std::optional<std::string> Core::GLTF::Json::parse(std::string_view source)
+{
+    CORE_TRACE_ZONE("Json::parse");
+    text = source;
+    tokenCount = 0;
+    containers.clear();
+    if (text.size() >= noToken)
+    {
+        return fail(0, "Document larger than 4 GiB");
+    }
+
+    std::optional<std::string> error = scan();
+    error = error ? error : link();
+    if (error)
+    {
+        tokenCount = 0;
+        containers.clear();
+    }
+    return error;
+}
+
+std::optional<std::string> Core::GLTF::Json::scan()
+{
+    // Blocks write up to 64 entries before the count is known
+    tokens = std::make_unique_for_overwrite<uint32_t[]>(text.size() + blockSize);
+    uint32_t *out = tokens.get();
+
+    uint64_t escapeCarry = 0;
+    uint64_t stringCarry = 0;
+    uint64_t scalarCarry = 0;
+    char tail[blockSize];
+
+    for (size_t base = 0; base < text.size(); base += blockSize)
+    {
+        const char *block = text.data() + base;
+        if (text.size() - base < blockSize)
+        {
+            // Pad the last block with whitespace, which never starts a token
+            std::memset(tail, ' ', blockSize);
+            std::memcpy(tail, block, text.size() - base);
+            block = tail;
+        }
+
+        BlockMasks masks = classify(block);
+        uint64_t escaped = masks.backslashes || escapeCarry ? findEscaped(masks.backslashes, escapeCarry) : 0;
+        uint64_t quotes = masks.quotes & ~escaped;
+        // Set from each opening quote up to, not including, its closing quote
+        uint64_t inString = prefixXor(quotes) ^ stringCarry;
+        stringCarry = static_cast<uint64_t>(static_cast<int64_t>(inString) >> 63);
+
+        if (uint64_t invalid = masks.controls & inString; invalid)
+        {
+            return fail(base + std::countr_zero(invalid), "Control character in string");
+        }
+
+        // Numbers and literals are runs of anything else outside strings
+        uint64_t scalars = ~(masks.whitespace | masks.operators | quotes | inString);
+        uint64_t scalarStarts = scalars & ~((scalars << 1) | scalarCarry);
+        scalarCarry = scalars >> 63;
+
+        uint64_t found = (masks.operators & ~inString) | quotes | scalarStarts;
+        while (found)
+        {
+            *out++ = static_cast<uint32_t>(base + std::countr_zero(found));
+            found &= found - 1;
+        }
+    }
+
+    tokenCount = static_cast<uint32_t>(out - tokens.get());
+    if (stringCarry)
+    {
+        return fail(text.size(), "Unterminated string");
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> Core::GLTF::Json::link()
+{
+    uint32_t count = tokenCount;
+    auto at = [&](uint32_t token)
+    { return token < count ? text[tokens[token]] : '\0'; };
+    auto offset = [&](uint32_t token)
+    { return token < count ? size_t(tokens[token]) : text.size(); };
+
+    struct Open
+    {
+        uint32_t token;
+        uint32_t container;
+    };
+    std::vector<Open> stack;
+
+    // Steps over a member key and its ':', quotes come in pairs after
+    // the first stage
+    auto memberKey = [&](uint32_t &token) -> std::optional<std::string>
+    {
+        if (at(token) != '"')
+        {
+            return fail(offset(token), "Expected object key");
+        }
+        token += 2;
+        if (at(token) != ':')
+        {
+            return fail(offset(token), "Expected ':' after object key");
+        }
+        ++token;
+        return std::nullopt;
+    };
+
+    uint32_t token = 0;
+    while (true)
+    {
+        // A value starts here
+        char c = at(token);
+        if (token == count)
+        {
+            return fail(text.size(), "Unexpected end of input");
+        }
+        if (c == '{' || c == '[')
+        {
+            if (stack.size() == maxDepth)
+            {
+                return fail(offset(token), "Nesting too deep");
+            }
+            stack.push_back({token, static_cast<uint32_t>(containers.size())});
+            containers.push_back({0, 0, 0});
+            ++token;
+            if (at(token) != (c == '{' ? '}' : ']'))
+            {
+                containers.back().children = 1;
+                if (c == '{')
+                {
+                    if (auto error = memberKey(token); error)
+                    {
+                        return error;
+                    }
+                }
+                continue;
+            }
+        }
+        else if (c == '"')
+        {
+            token += 2;
+        }
+        else if (c == ',' || c == ':' || c == '}' || c == ']' || !isValidScalar(text, tokens[token]))
+        {
+            return fail(offset(token), "Invalid value");
+        }
+        else
+        {
+            ++token;
+        }
+
+        // After a value: close containers until one continues with ','
+        while (!stack.empty())
+        {
+            Open &open = stack.back();
+            bool object = at(open.token) == '{';
+            c = at(token);
+            if (c == ',')
+            {
+                ++containers[open.container].children;
+                ++token;
+                if (object)
+                {
+                    if (auto error = memberKey(token); error)
+                    {
+                        return error;
+                    }
+                }
+                break;
+            }
+            if (c != (object ? '}' : ']'))
+            {
+                return fail(offset(token), object ? "Expected '}'" : "Expected ']'");
+            }
+            Container &closed = containers[open.container];
+            closed.close = token;
+            closed.next = static_cast<uint32_t>(containers.size());
+            stack.pop_back();
+            ++token;
+        }
+        if (stack.empty())
+        {
+            break;
+        }
+    }
+
+    if (token != count)
+    {
+        return fail(offset(token), "Unexpected trailing characters");
+    }
+    return std::nullopt;
+}
+
+uint32_t Core::GLTF::Json::skip(uint32_t token, uint32_t &container) const noexcept
+{
+    char c = text[tokens[token]];
+    if (c == '{' || c == '[')
+    {
+        const Container &skipped = containers[container];
+        container = skipped.next;
+        return skipped.close + 1;
+    }
+    return c == '"' ? token + 2 : token + 1;
+}
+
+Core::GLTF::Json::Value Core::GLTF::Json::getRoot() const noexcept
+{
+    return tokenCount == 0 ? Value() : Value(this, 0, 0);
+}
+
+Core::GLTF::Json::Value::Iterator &Core::GLTF::Json::Value::Iterator::operator++()
+{
+    // Past the ',' unless the value was the last one
+    uint32_t next = json->skip(members ? token + 3 : token, container);
+    token = next == close ? next : next + 1;
+    return *this;
+}
+
+Core::GLTF::Json::Type Core::GLTF::Json::Value::getType() const noexcept
+{
+    if (!json)
+    {
+        return Type::Null;
+    }
+    switch (first())
+    {
+    case '{':
+        return Type::Object;
+    case '[':
+        return Type::Array;
+    case '"':
+        return Type::String;
+    case 't':
+    case 'f':
+        return Type::Bool;
+    case 'n':
+        return Type::Null;
+    default:
+        return Type::Number;
+    }
+}
+
+size_t Core::GLTF::Json::Value::size() const noexcept
+{
+    if (!isArray() && !isObject())
+    {
+        return 0;
+    }
+    return json->containers[container].children;
+}
+
+std::string_view Core::GLTF::Json::Value::key() const noexcept
+{
+    if (!json || keyToken == noToken)
+    {
+        return {};
+    }
+    uint32_t start = json->tokens[keyToken] + 1;
+    return json->text.substr(start, json->tokens[keyToken + 1] - start);
+}
+
+Core::GLTF::Json::Value Core::GLTF::Json::Value::operator[](std::string_view member) const noexcept
+{
+    if (!isObject())
+    {
+        return {};
+    }
+    // Key lengths come from the token offsets, so only keys of the right
+    // length are compared against the text
+    const uint32_t *tokens = json->tokens.get();
+    uint32_t close = json->containers[container].close;
+    uint32_t next = container + 1;
+    for (uint32_t key = token + 1; key != close;)
+    {
+        uint32_t start = tokens[key] + 1;
+        if (tokens[key + 1] - start == member.size() && json->text.compare(start, member.size(), member) == 0)
+        {
+            return {json, key + 3, next, key};
+        }
+        key = json->skip(key + 3, next);
+        key += key != close;
+    }
+    return {};
+}
+
+Core::GLTF::Json::Value Core::GLTF::Json::Value::operator[](size_t element) const noexcept
+{
+    if (!isArray() || element >= size())
+    {
+        return {};
+    }
+    Iterator child = begin();
+    for (size_t i = 0; i < element; ++i)
+    {
+        ++child;
+    }
+    return *child;
+}
+
+double Core::GLTF::Json::Value::asNumber(double fallback) const noexcept
+{
+    if (!isNumber())
+    {
+        return fallback;
+    }
+    const char *begin = json->text.data() + json->tokens[token];
+    const char *end = json->text.data() + json->text.size();
+    if (auto number = parseShortNumber(begin, end); number)
+    {
+        return *number;
+    }
+
+    // Validated by the second stage, from_chars stops at the delimiter.
+    // Out of range values leave the fallback.
+    double number = fallback;
+    std::from_chars(begin, end, number);
+    return number;
+}
+
+uint32_t Core::GLTF::Json::Value::asUInt(uint32_t fallback) const noexcept
+{
+    double value = asNumber(-1.0);
+    // Written so that NaN fails too
+    if (!(value >= 0.0 && value <= std::numeric_limits<uint32_t>::max()))
+    {
+        return fallback;
+    }
+    return static_cast<uint32_t>(value);
+}
+
+size_t Core::GLTF::Json::Value::asSize(size_t fallback) const noexcept
+{
+    double value = asNumber(-1.0);
+    // The largest size_t rounds up to 2^64 as a double, which does not fit
+    if (!(value >= 0.0 && value < static_cast<double>(std::numeric_limits<size_t>::max())))
+    {
+        return fallback;
+    }
+    return static_cast<size_t>(value);
+}
+
+bool Core::GLTF::Json::Value::asBool(bool fallback) const noexcept
+{
+    return getType() == Type::Bool ? first() == 't' : fallback;
+}
+
+std::optional<uint32_t> Core::GLTF::Json::Value::asIndex() const noexcept
+{
+    if (!isNumber() || first() == '-')
+    {
+        return std::nullopt;
+    }
+    return asUInt();
+}
+
+std::string_view Core::GLTF::Json::Value::asStringView() const noexcept
+{
+    if (!isString())
+    {
+        return {};
+    }
+    uint32_t start = json->tokens[token] + 1;
+    return json->text.substr(start, json->tokens[token + 1] - start);
+}
+
+std::string Core::GLTF::Json::Value::asString() const
+{
+    std::string_view raw = asStringView();
+    if (raw.find('\\') == std::string_view::npos)
+    {
+        return std::string(raw);
+    }
+
+    std::string out;
+    out.reserve(raw.size());
+    for (size_t i = 0; i < raw.size(); ++i)
+    {
+        if (raw[i] != '\\' || i + 1 >= raw.size())
+        {
+            out += raw[i];
+            continue;
+        }
+
+        char escape = raw[++i];
+        switch (escape)
+        {
+        case 'b':
+            out += '\b';
+            break;
+        case 'f':
+            out += '\f';
+            break;
+        case 'n':
+            out += '\n';
+            break;
+        case 'r':
+            out += '\r';
+            break;
+        case 't':
+            out += '\t';
+            break;
+        case 'u':
+        {
+            uint32_t codepoint = parseHex4(raw, i + 1);
+            i += 4;
+            if (codepoint >= 0xD800 && codepoint < 0xDC00 && i + 6 < raw.size() && raw[i + 1] == '\\' && raw[i + 2] == 'u')
+            {
+                uint32_t low = parseHex4(raw, i + 3);
+                if (low >= 0xDC00 && low < 0xE000)
+                {
+                    codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                    i += 6;
+                }
+            }
+            appendUtf8(out, codepoint);
+            break;
+        }
+        default:
+            // \" \\ and \/ map to themselves
+            out += escape;
+            break;
+        }
+    }
+    return out;
+}
+
+Core::GLTF::Json::Value::Iterator Core::GLTF::Json::Value::begin() const noexcept
+{
+    if (!isArray() && !isObject())
+    {
+        return end();
+    }
+    return {json, token + 1, container + 1, json->containers[container].close, first() == '{'};
+}
+
+Core::GLTF::Json::Value::Iterator Core::GLTF::Json::Value::end() const noexcept
+{
+    if (!isArray() && !isObject())
+    {
+        return {json, 0, 0, 0, false};
+    }
+    uint32_t close = json->containers[container].close;
+    return {json, close, 0, close, false};
+}
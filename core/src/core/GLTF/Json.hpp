@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <optional>
+#include <vector>
+
+namespace Core::GLTF
+{
+    // JSON reader for glTF scene descriptions, parsed in two stages. The
+    // first scans the text 64 bytes at a time with SIMD compares and records
+    // the offset of every structural character, both quotes of every string
+    // and the first character of every number or literal. The second walks
+    // those offsets once to check the grammar and records, per array and
+    // object, where it closes and how many children it has. Values are
+    // positions in that index: strings stay views into the text and numbers
+    // are converted when read, so nothing is allocated per JSON value and
+    // skipping a subtree is one lookup. The text must outlive the document.
+    class Json
+    {
+    public:
+        enum class Type : uint8_t
+        {
+            Null,
+            Bool,
+            Number,
+            String,
+            Array,
+            Object
+        };
+
+        static constexpr uint32_t noToken = UINT32_MAX;
+
+    private:
+        std::string_view text;
+        // Stage one: byte offset of every token. Sized for the worst case of
+        // a token per byte and left uninitialised, so only the part written
+        // is ever paged in.
+        std::unique_ptr<uint32_t[]> tokens;
+        uint32_t tokenCount = 0;
+
+        // Stage two: arrays and objects in the order they open
+        struct Container
+        {
+            uint32_t close;    // token of the closing bracket
+            uint32_t children; // elements or members
+            uint32_t next;     // first container after this one's subtree
+        };
+        std::vector<Container> containers;
+
+    public:
+        class Value
+        {
+        private:
+            const Json *json = nullptr;
+            uint32_t token = 0;
+            // The container this value opens, or the next one after it
+            uint32_t container = 0;
+            uint32_t keyToken = noToken;
+
+        public:
+            Value() = default;
+            Value(const Json *owner, uint32_t valueToken, uint32_t containerIndex, uint32_t memberKeyToken = noToken)
+                : json(owner), token(valueToken), container(containerIndex), keyToken(memberKeyToken) {}
+
+            // Walks the children of an array, or the members of an object
+            // starting at their key
+            class Iterator
+            {
+            private:
+                const Json *json;
+                uint32_t token;
+                uint32_t container;
+                uint32_t close; // the parent's closing bracket
+                bool members;
+
+            public:
+                Iterator(const Json *owner, uint32_t childToken, uint32_t containerIndex, uint32_t closeToken, bool objectMembers)
+                    : json(owner), token(childToken), container(containerIndex), close(closeToken), members(objectMembers) {}
+                Value operator*() const { return members ? Value(json, token + 3, container, token) : Value(json, token, container); }
+                Iterator &operator++();
+                bool operator!=(const Iterator &other) const { return token != other.token; }
+            };
+
+            [[nodiscard]] explicit operator bool() const noexcept { return json != nullptr; }
+            [[nodiscard]] Type getType() const noexcept;
+            [[nodiscard]] bool isObject() const noexcept { return getType() == Type::Object; }
+            [[nodiscard]] bool isArray() const noexcept { return getType() == Type::Array; }
+            [[nodiscard]] bool isNumber() const noexcept { return getType() == Type::Number; }
+            [[nodiscard]] bool isString() const noexcept { return getType() == Type::String; }
+
+            [[nodiscard]] size_t size() const noexcept;
+            [[nodiscard]] std::string_view key() const noexcept;
+
+            // Missing members and out of range elements yield an empty Value
+            Value operator[](std::string_view member) const noexcept;
+            Value operator[](size_t element) const noexcept;
+
+            [[nodiscard]] double asNumber(double fallback = 0.0) const noexcept;
+            [[nodiscard]] uint32_t asUInt(uint32_t fallback = 0) const noexcept;
+            [[nodiscard]] size_t asSize(size_t fallback = 0) const noexcept;
+            [[nodiscard]] bool asBool(bool fallback = false) const noexcept;
+            [[nodiscard]] std::optional<uint32_t> asIndex() const noexcept;
+            // Raw view of the string contents; escape sequences are not decoded
+            [[nodiscard]] std::string_view asStringView() const noexcept;
+            [[nodiscard]] std::string asString() const;
+
+            Iterator begin() const noexcept;
+            Iterator end() const noexcept;
+
+        private:
+            char first() const noexcept { return json->text[json->tokens[token]]; }
+        };
+
+        std::optional<std::string> parse(std::string_view source);
+        [[nodiscard]] Value getRoot() const noexcept;
+
+        // Tokens found by the first stage, for sizing and statistics
+        [[nodiscard]] size_t getTokenCount() const noexcept { return tokenCount; }
+
+    private:
+        std::optional<std::string> scan();
+        std::optional<std::string> link();
+        // Index of the token after the value starting at token. container is
+        // the value's container index and moves past its subtree.
+        uint32_t skip(uint32_t token, uint32_t &container) const noexcept;
+    };
+}
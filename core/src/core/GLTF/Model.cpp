@@ -0,0 +1,433 @@
+#include "Model.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "../MeshOptimizer.hpp"
+#include "../Trace.hpp"
+#include "Accessor.hpp"
+
+namespace
+{
+    constexpr size_t noBuffer = static_cast<size_t>(-1);
+
+    std::optional<GLuint> findAttributeLocation(std::string_view name)
+    {
+        for (const auto &[attribute, location] : Core::GLTF::attributeLocations)
+        {
+            if (attribute == name)
+            {
+                return location;
+            }
+        }
+        return std::nullopt;
+    }
+
+    // POSITION as packed xyz floats for the overdraw pass, shared by every
+    // triangle list that uses the same accessor. Read in place when the
+    // buffer view stores it that way and decoded otherwise, only once the
+    // vertex cache pass has released its tables.
+    struct PositionCache
+    {
+        std::optional<uint32_t> accessor;
+        std::vector<float> storage;
+        std::span<const float> positions;
+
+        // Empty when the accessor cannot be read
+        std::span<const float> read(const Core::GLTF::Document &document, uint32_t position, Core::JobSystem &jobs)
+        {
+            if (accessor == position)
+            {
+                return positions;
+            }
+
+            accessor = position;
+            const auto &info = document.getAccessors()[position];
+            auto data = document.getAccessorData(position);
+            if (info.componentType == GL_FLOAT && info.components == 3 && !info.sparse && !data.empty() &&
+                document.getAccessorStride(position) == 3 * sizeof(float) && reinterpret_cast<uintptr_t>(data.data()) % alignof(float) == 0)
+            {
+                storage = {};
+                positions = {reinterpret_cast<const float *>(data.data()), info.count * 3};
+                return positions;
+            }
+
+            storage.clear();
+            storage.resize(info.count * 3);
+            positions = Core::GLTF::decodeFloats(document, position, storage, jobs) ? std::span<const float>() : std::span<const float>(storage);
+            return positions;
+        }
+    };
+
+    // Copies an index accessor in its own width, reorders it for the vertex
+    // cache and overdraw when it has a POSITION accessor to reorder against,
+    // and uploads it
+    template <typename Index>
+    std::optional<std::string> uploadIndices(const Core::GLTF::Document &document, uint32_t accessor, std::optional<uint32_t> position,
+                                             PositionCache &positions, Core::GL::GLBuffer &buffer, Core::VertexCacheStatistics &before,
+                                             Core::VertexCacheStatistics &after, Core::JobSystem &jobs)
+    {
+        std::vector<Index> indices(document.getAccessors()[accessor].count);
+        if (auto error = Core::GLTF::decodeIndices(document, accessor, std::span(indices), jobs); error)
+        {
+            return error;
+        }
+        if (position)
+        {
+            size_t vertexCount = document.getAccessors()[*position].count;
+            before += Core::analyzeVertexCache(std::span<const Index>(indices), vertexCount);
+            Core::optimizeVertexCache(std::span(indices), vertexCount);
+            if (auto data = positions.read(document, *position, jobs); !data.empty())
+            {
+                Core::optimizeOverdraw(std::span(indices), data);
+            }
+            after += Core::analyzeVertexCache(std::span<const Index>(indices), vertexCount);
+        }
+        return buffer.setData(std::span(indices));
+    }
+}
+
+std::optional<std::string> Core::GLTF::Model::upload(const Document &document, JobSystem &jobs)
+{
+    CORE_TRACE_ZONE("Model::upload");
+    const auto &accessors = document.getAccessors();
+    const auto &bufferViews = document.getBufferViews();
+
+    // Attributes in a format the vertex fetch reads, quantized ones
+    // included, and uint16/uint32 indices are drawn straight from their
+    // buffer view, other attributes are converted to float and uint8 indices
+    // to uint16 first. Triangle lists are always copied, in their own width,
+    // so their indices can be reordered for the vertex cache and overdraw,
+    // which leaves the vertices in place.
+    enum class Source : uint8_t
+    {
+        Unused,
+        View,
+        DecodeFloats,
+        DecodeIndices
+    };
+    std::vector<Source> accessorSources(accessors.size(), Source::Unused);
+    std::vector<GL::BufferType> viewTypes(bufferViews.size(), GL::BufferType::Vertex);
+    std::vector<bool> viewUsed(bufferViews.size(), false);
+    // The POSITION accessor each triangle list is reordered against, unset
+    // for index accessors that some other primitive draws differently
+    std::vector<std::optional<uint32_t>> reorderPositions(accessors.size());
+    std::vector<bool> keepOrder(accessors.size(), false);
+    for (const auto &mesh : document.getMeshes())
+    {
+        for (const auto &primitive : mesh.primitives)
+        {
+            if (!primitive.indices)
+            {
+                continue;
+            }
+            auto position = primitive.findAttribute("POSITION");
+            bool triangles = primitive.mode == GL_TRIANGLES && position && accessors[*position].components == 3 &&
+                             accessors[*primitive.indices].count % 3 == 0;
+            auto &target = reorderPositions[*primitive.indices];
+            if (!triangles || (target && *target != *position))
+            {
+                keepOrder[*primitive.indices] = true;
+            }
+            target = position;
+        }
+    }
+    for (uint32_t i = 0; i < accessors.size(); ++i)
+    {
+        if (keepOrder[i])
+        {
+            reorderPositions[i].reset();
+        }
+    }
+    for (const auto &mesh : document.getMeshes())
+    {
+        for (const auto &primitive : mesh.primitives)
+        {
+            for (const auto &attribute : primitive.attributes)
+            {
+                if (!findAttributeLocation(attribute.name))
+                {
+                    continue;
+                }
+                if (getVertexFormat(document, attribute.accessor))
+                {
+                    accessorSources[attribute.accessor] = Source::View;
+                    viewUsed[*accessors[attribute.accessor].bufferView] = true;
+                }
+                else
+                {
+                    accessorSources[attribute.accessor] = Source::DecodeFloats;
+                }
+            }
+            if (primitive.indices)
+            {
+                const auto &accessor = accessors[*primitive.indices];
+                bool native = accessor.componentType == GL_UNSIGNED_INT || accessor.componentType == GL_UNSIGNED_SHORT;
+                if (native && accessor.bufferView && document.getAccessorStride(*primitive.indices) == accessor.componentSize() &&
+                    !reorderPositions[*primitive.indices])
+                {
+                    accessorSources[*primitive.indices] = Source::View;
+                    viewUsed[*accessor.bufferView] = true;
+                    viewTypes[*accessor.bufferView] = GL::BufferType::Index;
+                }
+                else
+                {
+                    accessorSources[*primitive.indices] = Source::DecodeIndices;
+                }
+            }
+        }
+    }
+
+    // All buffers are created before any VAO references them, the VAOs keep
+    // references into this vector
+    meshes.clear();
+    buffers.clear();
+    std::vector<uint32_t> converted;
+    for (uint32_t i = 0; i < accessors.size(); ++i)
+    {
+        if (accessorSources[i] == Source::DecodeFloats || accessorSources[i] == Source::DecodeIndices)
+        {
+            converted.push_back(i);
+        }
+    }
+    buffers.reserve(bufferViews.size() + converted.size());
+    std::vector<size_t> viewBuffers(bufferViews.size(), noBuffer);
+    std::vector<size_t> accessorBuffers(accessors.size(), noBuffer);
+    std::vector<GLenum> accessorIndexTypes(accessors.size(), GL_UNSIGNED_INT);
+    cacheBefore = {};
+    cacheAfter = {};
+
+    // Converted accessors are decoded, reordered and uploaded one at a time,
+    // each decode spread across the job system, so a single staging copy is
+    // alive at once. Triangle lists are grouped by POSITION accessor, which
+    // is read once per group.
+    std::stable_sort(converted.begin(), converted.end(), [&](uint32_t a, uint32_t b)
+                     { return reorderPositions[a] < reorderPositions[b]; });
+    PositionCache positions;
+    for (uint32_t accessor : converted)
+    {
+        const auto &info = accessors[accessor];
+        std::optional<std::string> error;
+        if (accessorSources[accessor] == Source::DecodeFloats)
+        {
+            auto &buffer = buffers.emplace_back(GL::BufferType::Vertex);
+            std::vector<float> floats(info.count * info.components);
+            error = decodeFloats(document, accessor, floats, jobs);
+            error = error ? error : buffer.setData(std::span(floats));
+        }
+        else
+        {
+            auto &buffer = buffers.emplace_back(GL::BufferType::Index);
+            if (info.componentType == GL_UNSIGNED_INT)
+            {
+                error = uploadIndices<uint32_t>(document, accessor, reorderPositions[accessor], positions, buffer, cacheBefore, cacheAfter, jobs);
+            }
+            else
+            {
+                error = uploadIndices<uint16_t>(document, accessor, reorderPositions[accessor], positions, buffer, cacheBefore, cacheAfter, jobs);
+                accessorIndexTypes[accessor] = GL_UNSIGNED_SHORT;
+            }
+        }
+        if (error)
+        {
+            return "Accessor " + std::to_string(accessor) + ": " + *error;
+        }
+        accessorBuffers[accessor] = buffers.size() - 1;
+    }
+    positions = {};
+
+    // Buffer views go up after the conversions so their GL copies do not
+    // add to the peak of the reordering
+    for (uint32_t view = 0; view < bufferViews.size(); ++view)
+    {
+        if (!viewUsed[view])
+        {
+            continue;
+        }
+
+        auto data = document.getBufferViewData(view);
+        auto &buffer = buffers.emplace_back(viewTypes[view]);
+        if (auto error = buffer.setData(data.size(), data.data()); error)
+        {
+            return "Buffer view " + std::to_string(view) + ": " + *error;
+        }
+        viewBuffers[view] = buffers.size() - 1;
+    }
+
+    for (const auto &mesh : document.getMeshes())
+    {
+        auto &primitives = meshes.emplace_back();
+        primitives.reserve(mesh.primitives.size());
+        for (const auto &source : mesh.primitives)
+        {
+            auto position = source.findAttribute("POSITION");
+            if (!position)
+            {
+                std::cerr << "Skipping primitive without POSITION in mesh '" << mesh.name << "'\n";
+                continue;
+            }
+
+            auto &primitive = primitives.emplace_back();
+            primitive.mode = source.mode;
+            primitive.material = source.material;
+            primitive.features = shaderFeatures(document, source);
+            primitive.count = static_cast<GLsizei>(accessors[*position].count);
+
+            for (const auto &attribute : source.attributes)
+            {
+                auto location = findAttributeLocation(attribute.name);
+                if (!location)
+                {
+                    continue;
+                }
+
+                const auto &accessor = accessors[attribute.accessor];
+                if (accessorSources[attribute.accessor] == Source::View)
+                {
+                    auto format = *getVertexFormat(document, attribute.accessor);
+                    primitive.vao.addVertexBuffer(buffers[viewBuffers[*accessor.bufferView]], *location,
+                                                  static_cast<GLint>(accessor.components), format.type, format.normalized,
+                                                  format.stride, accessor.byteOffset);
+                }
+                else
+                {
+                    primitive.vao.addVertexBuffer(buffers[accessorBuffers[attribute.accessor]], *location,
+                                                  static_cast<GLint>(accessor.components), GL_FLOAT, GL_FALSE, 0, 0);
+                }
+            }
+
+            if (source.indices)
+            {
+                const auto &accessor = accessors[*source.indices];
+                if (accessorSources[*source.indices] == Source::View)
+                {
+                    primitive.vao.setIndexBuffer(buffers[viewBuffers[*accessor.bufferView]]);
+                    primitive.indexOffset = accessor.byteOffset;
+                    primitive.indexType = accessor.componentType;
+                }
+                else
+                {
+                    primitive.vao.setIndexBuffer(buffers[accessorBuffers[*source.indices]]);
+                    primitive.indexOffset = 0;
+                    primitive.indexType = accessorIndexTypes[*source.indices];
+                }
+                primitive.count = static_cast<GLsizei>(accessor.count);
+            }
+        }
+    }
+
+    instances.clear();
+    for (const auto &[node, transform] : document.getNodeWorldTransforms())
+    {
+        if (auto mesh = document.getNodes()[node].mesh; mesh)
+        {
+            instances.push_back({*mesh, transform});
+        }
+    }
+
+    return std::nullopt;
+}
+
+void Core::GLTF::Model::drawMesh(uint32_t mesh) const
+{
+    for (const auto &primitive : meshes[mesh])
+    {
+        primitive.vao.bind();
+        if (primitive.indexType)
+        {
+            glDrawElements(primitive.mode, primitive.count, primitive.indexType, reinterpret_cast<const void *>(primitive.indexOffset));
+        }
+        else
+        {
+            glDrawArrays(primitive.mode, 0, primitive.count);
+        }
+    }
+    GL::GLState::current().bindVertexArray(0);
+}
+
+void Core::GLTF::Model::enqueue(GL::RenderQueue &queue, const GL::DrawPacket &base, const glm::mat4 &viewProjection) const
+{
+    enqueuePrimitives(queue, base, nullptr, viewProjection);
+}
+
+void Core::GLTF::Model::enqueue(GL::RenderQueue &queue, const GL::DrawPacket &base, GL::ShaderVariants &variants, const glm::mat4 &viewProjection) const
+{
+    enqueuePrimitives(queue, base, &variants, viewProjection);
+}
+
+void Core::GLTF::Model::enqueuePrimitives(GL::RenderQueue &queue, const GL::DrawPacket &base, GL::ShaderVariants *variants, const glm::mat4 &viewProjection) const
+{
+    for (const auto &instance : instances)
+    {
+        glm::vec4 origin = viewProjection * instance.transform[3];
+        float depth = origin.w != 0.0f ? origin.z / origin.w * 0.5f + 0.5f : 0.0f;
+
+        for (const auto &primitive : meshes[instance.mesh])
+        {
+            GL::DrawPacket packet = base;
+            if (variants)
+            {
+                packet.program = variants->get(primitive.features).getID();
+            }
+            packet.vertexArray = primitive.vao.getID();
+            packet.mode = primitive.mode;
+            packet.count = primitive.count;
+            packet.indexType = primitive.indexType;
+            packet.indexOffset = primitive.indexOffset;
+            packet.transform = instance.transform;
+            queue.push(packet, depth);
+        }
+    }
+}
+
+std::vector<Core::GL::ShaderVariants::Features> Core::GLTF::Model::getShaderFeatures() const
+{
+    std::vector<GL::ShaderVariants::Features> features;
+    for (const auto &primitives : meshes)
+    {
+        for (const auto &primitive : primitives)
+        {
+            if (std::find(features.begin(), features.end(), primitive.features) == features.end())
+            {
+                features.push_back(primitive.features);
+            }
+        }
+    }
+    return features;
+}
+
+std::vector<Core::GL::ShaderVariants::Feature> Core::GLTF::shaderFeatureDefines()
+{
+    return {
+        {ShaderFeature::NormalMap, "HAS_NORMAL_MAP"},
+        {ShaderFeature::Skinning, "HAS_SKINNING"},
+        {ShaderFeature::AlphaMask, "ALPHA_MASK"},
+        {ShaderFeature::VertexColors, "HAS_VERTEX_COLORS"},
+    };
+}
+
+Core::GL::ShaderVariants::Features Core::GLTF::shaderFeatures(const Document &document, const Primitive &primitive) noexcept
+{
+    GL::ShaderVariants::Features features = 0;
+    if (primitive.findAttribute("JOINTS_0") && primitive.findAttribute("WEIGHTS_0"))
+    {
+        features |= ShaderFeature::Skinning;
+    }
+    if (primitive.findAttribute("COLOR_0"))
+    {
+        features |= ShaderFeature::VertexColors;
+    }
+    if (primitive.material)
+    {
+        const auto &material = document.getMaterials()[*primitive.material];
+        if (material.normalTexture && primitive.findAttribute("NORMAL"))
+        {
+            features |= ShaderFeature::NormalMap;
+        }
+        if (material.alphaMode == Material::AlphaMode::Mask)
+        {
+            features |= ShaderFeature::AlphaMask;
+        }
+    }
+    return features;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <array>
+#include <string>
+#include <vector>
+#include <optional>
+#include <string_view>
+#include <glm/glm.hpp>
+
+#include "../GL/GLBuffer.hpp"
+#include "../GL/RenderQueue.hpp"
+#include "../GL/ShaderVariants.hpp"
+#include "../GL/VAO.hpp"
+#include "../JobSystem.hpp"
+#include "../MeshOptimizer.hpp"
+#include "Document.hpp"
+
+namespace Core::GLTF
+{
+    // Vertex attribute locations shared by every shader that draws glTF meshes
+    inline constexpr std::array<std::pair<std::string_view, GLuint>, 8> attributeLocations = {{
+        {"POSITION", 0},
+        {"TEXCOORD_0", 1},
+        {"NORMAL", 2},
+        {"TANGENT", 3},
+        {"COLOR_0", 4},
+        {"JOINTS_0", 5},
+        {"WEIGHTS_0", 6},
+        {"TEXCOORD_1", 7},
+    }};
+
+    // Shader variant bits a primitive can need, see shaderFeatureDefines
+    namespace ShaderFeature
+    {
+        inline constexpr GL::ShaderVariants::Features NormalMap = 1u << 0;
+        inline constexpr GL::ShaderVariants::Features Skinning = 1u << 1;
+        inline constexpr GL::ShaderVariants::Features AlphaMask = 1u << 2;
+        inline constexpr GL::ShaderVariants::Features VertexColors = 1u << 3;
+    }
+
+    // The #define for each ShaderFeature, as the glTF shaders test them
+    [[nodiscard]] std::vector<GL::ShaderVariants::Feature> shaderFeatureDefines();
+
+    // Features a primitive's attributes and material call for
+    [[nodiscard]] GL::ShaderVariants::Features shaderFeatures(const Document &document, const Primitive &primitive) noexcept;
+
+    // GPU resources for a glTF document. Float and quantized integer
+    // attributes and uint16/uint32 indices are uploaded directly from the
+    // document's mapped memory, one buffer per buffer view, so quantized
+    // data keeps its size on the GPU; other accessors are decoded to float,
+    // or uint16 for uint8 indices, across the job system and uploaded one at
+    // a time. Triangle list indices are copied in their own width and
+    // reordered for the vertex cache and overdraw; vertex data keeps its order.
+    class Model
+    {
+    public:
+        struct Primitive
+        {
+            GL::VAO vao;
+            GLenum mode = GL_TRIANGLES;
+            GLsizei count = 0;
+            GLenum indexType = 0; // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, 0 when drawn with glDrawArrays
+            size_t indexOffset = 0;
+            std::optional<uint32_t> material;
+            GL::ShaderVariants::Features features = 0;
+        };
+
+        struct Instance
+        {
+            uint32_t mesh;
+            glm::mat4 transform;
+        };
+
+    private:
+        std::vector<GL::GLBuffer> buffers;
+        std::vector<std::vector<Primitive>> meshes;
+        std::vector<Instance> instances;
+        VertexCacheStatistics cacheBefore;
+        VertexCacheStatistics cacheAfter;
+
+    public:
+        Model() = default;
+
+        // The following prevents copying, but allows moving
+        Model(const Model &) = delete;
+        Model &operator=(const Model &) = delete;
+        Model(Model &&other) noexcept = default;
+        Model &operator=(Model &&other) noexcept = default;
+
+        std::optional<std::string> upload(const Document &document, JobSystem &jobs = JobSystem::shared());
+
+        void drawMesh(uint32_t mesh) const;
+
+        // Records one packet per primitive of every instance. Program,
+        // texture, pass and uniform location come from base, depth from each
+        // instance origin projected by viewProjection.
+        void enqueue(GL::RenderQueue &queue, const GL::DrawPacket &base, const glm::mat4 &viewProjection = glm::mat4(1.0f)) const;
+
+        // As above, with each primitive drawn by the variant for its features
+        void enqueue(GL::RenderQueue &queue, const GL::DrawPacket &base, GL::ShaderVariants &variants, const glm::mat4 &viewProjection = glm::mat4(1.0f)) const;
+
+        // Every feature combination some primitive uses, for
+        // ShaderVariants::prepare
+        [[nodiscard]] std::vector<GL::ShaderVariants::Features> getShaderFeatures() const;
+
+        [[nodiscard]] const std::vector<Instance> &getInstances() const noexcept { return instances; }
+        [[nodiscard]] const std::vector<std::vector<Primitive>> &getMeshes() const noexcept { return meshes; }
+        [[nodiscard]] const std::vector<GL::GLBuffer> &getBuffers() const noexcept { return buffers; }
+
+        // Vertex cache behaviour of the triangle lists before and after the
+        // last upload reordered them
+        [[nodiscard]] const VertexCacheStatistics &getCacheBefore() const noexcept { return cacheBefore; }
+        [[nodiscard]] const VertexCacheStatistics &getCacheAfter() const noexcept { return cacheAfter; }
+
+    private:
+        void enqueuePrimitives(GL::RenderQueue &queue, const GL::DrawPacket &base, GL::ShaderVariants *variants, const glm::mat4 &viewProjection) const;
+    };
+}
@@ -0,0 +1,106 @@
+#include "SceneCache.hpp"
+
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+
+#include "../Hash.hpp"
+#include "../Trace.hpp"
+
+namespace
+{
+    constexpr uint32_t sceneMagic = 0x43534B43; // "CKSC"
+    // Bumped whenever StaticBatch::Primitive or Instance, or what decode()
+    // does to the streams, change
+    constexpr uint32_t sceneVersion = 2;
+
+    static_assert(sizeof(Core::GLTF::StaticBatch::Primitive) == 20);
+    static_assert(sizeof(Core::GLTF::StaticBatch::Instance) == 80);
+
+    enum Section : uint32_t
+    {
+        Positions,
+        TexCoords,
+        Normals,
+        Indices,
+        Primitives,
+        MeshPrimitives,
+        Instances
+    };
+}
+
+Core::GLTF::SceneCache::SceneCache(std::string cacheDirectory)
+    : directory(std::move(cacheDirectory))
+{
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error)
+    {
+        std::cerr << "Scene cache disabled: " << directory << ": " << error.message() << '\n';
+        return;
+    }
+    enabled = true;
+}
+
+std::optional<Core::CookedFile> Core::GLTF::SceneCache::load(const std::string &sourcePath, StaticBatch::Geometry &geometry, JobSystem &jobs) const
+{
+    CORE_TRACE_ZONE("SceneCache::load");
+    if (!enabled)
+    {
+        return std::nullopt;
+    }
+
+    std::string path = entryPath(sourcePath);
+    if (!std::filesystem::exists(path))
+    {
+        return std::nullopt;
+    }
+
+    CookedFile file;
+    if (auto error = file.open(path, sceneMagic, sceneVersion); error)
+    {
+        std::cerr << "Ignoring scene cache entry: " << *error << '\n';
+        return std::nullopt;
+    }
+    auto sources = file.getSourcePaths();
+    if (sources.empty() || sources.front() != sourcePath || !file.isCurrent(jobs))
+    {
+        return std::nullopt;
+    }
+
+    geometry.positions = file.getSection<float>(Positions);
+    geometry.texCoords = file.getSection<float>(TexCoords);
+    geometry.normals = file.getSection<float>(Normals);
+    geometry.indices = file.getSection<uint32_t>(Indices);
+    geometry.primitives = file.getSection<StaticBatch::Primitive>(Primitives);
+    geometry.meshPrimitives = file.getSection<uint32_t>(MeshPrimitives);
+    geometry.instances = file.getSection<StaticBatch::Instance>(Instances);
+    return file;
+}
+
+std::optional<std::string> Core::GLTF::SceneCache::store(const std::string &sourcePath, const Document &document,
+                                                         const StaticBatch::Geometry &geometry, JobSystem &jobs) const
+{
+    CORE_TRACE_ZONE("SceneCache::store");
+    if (!enabled)
+    {
+        return std::nullopt;
+    }
+
+    CookedFile::Writer writer(sceneMagic, sceneVersion, document.getSourcePaths());
+    writer.addSection(Positions, geometry.positions);
+    writer.addSection(TexCoords, geometry.texCoords);
+    writer.addSection(Normals, geometry.normals);
+    writer.addSection(Indices, geometry.indices);
+    writer.addSection(Primitives, geometry.primitives);
+    writer.addSection(MeshPrimitives, geometry.meshPrimitives);
+    writer.addSection(Instances, geometry.instances);
+    return writer.write(entryPath(sourcePath), jobs);
+}
+
+std::string Core::GLTF::SceneCache::entryPath(const std::string &sourcePath) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.scene", static_cast<unsigned long long>(fnv1a(sourcePath)));
+    return (std::filesystem::path(directory) / name).string();
+}
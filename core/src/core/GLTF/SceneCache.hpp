@@ -0,0 +1,41 @@
+#pragma once
+
+#include <optional>
+#include <string>
+
+#include "../CookedFile.hpp"
+#include "../JobSystem.hpp"
+#include "Document.hpp"
+#include "StaticBatch.hpp"
+
+namespace Core::GLTF
+{
+    // On-disk cache of StaticBatch geometry cooked from glTF files, so later
+    // runs map the decoded streams, primitive table and flat node table and
+    // upload them without reading JSON or converting accessors. Entries are
+    // named after the source path and checked against the content of the
+    // source and its external buffers, so an edited scene misses and is
+    // cooked again.
+    class SceneCache
+    {
+    private:
+        std::string directory;
+        bool enabled = false;
+
+    public:
+        explicit SceneCache(std::string cacheDirectory);
+
+        // The entry for sourcePath if it is current. The returned file backs
+        // the views placed in geometry and must outlive their upload.
+        std::optional<CookedFile> load(const std::string &sourcePath, StaticBatch::Geometry &geometry, JobSystem &jobs = JobSystem::shared()) const;
+
+        // Cooks geometry decoded from document, which was loaded from sourcePath
+        std::optional<std::string> store(const std::string &sourcePath, const Document &document, const StaticBatch::Geometry &geometry,
+                                         JobSystem &jobs = JobSystem::shared()) const;
+
+        [[nodiscard]] bool isEnabled() const noexcept { return enabled; }
+
+    private:
+        std::string entryPath(const std::string &sourcePath) const;
+    };
+}
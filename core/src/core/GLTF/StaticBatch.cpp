@@ -0,0 +1,284 @@
+#include "StaticBatch.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <numeric>
+#include <span>
+
+#include "../GL/GLState.hpp"
+#include "../GL/Profiler.hpp"
+#include "../Trace.hpp"
+#include "Accessor.hpp"
+
+namespace
+{
+    struct Source
+    {
+        const Core::GLTF::Primitive *primitive;
+        size_t index;
+        std::optional<std::string> error;
+        Core::VertexCacheStatistics cacheBefore{};
+        Core::VertexCacheStatistics cacheAfter{};
+    };
+
+    // Decodes one attribute into its slice of a shared stream, leaving the
+    // zero fill when the primitive lacks it or has the wrong shape
+    std::optional<std::string> decodeAttribute(const Core::GLTF::Document &document, const Core::GLTF::Primitive &primitive,
+                                               const Core::GLTF::StaticBatch::Primitive &range, std::string_view name,
+                                               uint32_t components, std::vector<float> &stream, Core::JobSystem &jobs)
+    {
+        auto accessor = primitive.findAttribute(name);
+        if (!accessor)
+        {
+            return std::nullopt;
+        }
+        const auto &info = document.getAccessors()[*accessor];
+        if (info.components != components || info.count != range.vertexCount)
+        {
+            std::cerr << "Ignoring " << name << " with unexpected layout in static batch\n";
+            return std::nullopt;
+        }
+        return Core::GLTF::decodeFloats(document, *accessor, std::span(stream).subspan(size_t(range.baseVertex) * components, size_t(range.vertexCount) * components), jobs);
+    }
+
+    // Reorders a decoded triangle list in place within its slices of the
+    // shared streams
+    void optimizeTriangles(Core::GLTF::StaticBatch::DecodedGeometry &geometry, const Core::GLTF::StaticBatch::Primitive &range, Source &source)
+    {
+        auto indices = std::span(geometry.indices).subspan(range.firstIndex, range.indexCount);
+        auto vertices = [&](std::vector<float> &stream, size_t components)
+        {
+            return std::span(stream).subspan(size_t(range.baseVertex) * components, size_t(range.vertexCount) * components);
+        };
+
+        source.cacheBefore = Core::analyzeVertexCache(indices, range.vertexCount);
+        Core::optimizeVertexCache(indices, range.vertexCount);
+        Core::optimizeOverdraw(indices, vertices(geometry.positions, 3));
+        auto remap = Core::optimizeVertexFetch(indices, range.vertexCount);
+        Core::remapVertices(vertices(geometry.positions, 3), 3, remap);
+        Core::remapVertices(vertices(geometry.texCoords, 2), 2, remap);
+        Core::remapVertices(vertices(geometry.normals, 3), 3, remap);
+        source.cacheAfter = Core::analyzeVertexCache(indices, range.vertexCount);
+    }
+}
+
+std::optional<std::string> Core::GLTF::StaticBatch::decode(const Document &document, DecodedGeometry &geometry, JobSystem &jobs)
+{
+    CORE_TRACE_ZONE("StaticBatch::decode");
+    const auto &accessors = document.getAccessors();
+    const auto &meshes = document.getMeshes();
+    geometry = DecodedGeometry();
+
+    // Lay out every primitive once, instances share its vertices
+    std::vector<Source> sources;
+    geometry.meshPrimitives.resize(meshes.size() + 1, 0);
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+    for (size_t mesh = 0; mesh < meshes.size(); ++mesh)
+    {
+        geometry.meshPrimitives[mesh] = static_cast<uint32_t>(geometry.primitives.size());
+        for (const auto &primitive : meshes[mesh].primitives)
+        {
+            auto position = primitive.findAttribute("POSITION");
+            if (!position)
+            {
+                std::cerr << "Skipping primitive without POSITION in mesh '" << meshes[mesh].name << "'\n";
+                continue;
+            }
+
+            size_t vertices = accessors[*position].count;
+            size_t primitiveIndices = primitive.indices ? accessors[*primitive.indices].count : vertices;
+            sources.push_back({&primitive, geometry.primitives.size(), {}});
+            geometry.primitives.push_back({primitive.mode, static_cast<uint32_t>(indexCount), static_cast<uint32_t>(primitiveIndices),
+                                           static_cast<uint32_t>(vertexCount), static_cast<uint32_t>(vertices)});
+            vertexCount += vertices;
+            indexCount += primitiveIndices;
+        }
+    }
+    geometry.meshPrimitives[meshes.size()] = static_cast<uint32_t>(geometry.primitives.size());
+    if (sources.empty() || indexCount == 0)
+    {
+        return "Document has no drawable primitives";
+    }
+    if (vertexCount > UINT32_MAX || indexCount > UINT32_MAX)
+    {
+        return "Document has too many vertices for a static batch";
+    }
+
+    geometry.positions.resize(vertexCount * 3);
+    geometry.texCoords.resize(vertexCount * 2, 0.0f);
+    geometry.normals.resize(vertexCount * 3, 0.0f);
+    geometry.indices.resize(indexCount);
+    jobs.parallelFor(sources.size(), 1, [&](size_t begin, size_t end)
+                     {
+        for (size_t i = begin; i < end; ++i)
+        {
+            auto &source = sources[i];
+            const auto &range = geometry.primitives[source.index];
+            source.error = decodeAttribute(document, *source.primitive, range, "POSITION", 3, geometry.positions, jobs);
+            source.error = source.error ? source.error : decodeAttribute(document, *source.primitive, range, "TEXCOORD_0", 2, geometry.texCoords, jobs);
+            source.error = source.error ? source.error : decodeAttribute(document, *source.primitive, range, "NORMAL", 3, geometry.normals, jobs);
+
+            // Indices stay relative to the primitive, baseVertex offsets them
+            auto out = std::span(geometry.indices).subspan(range.firstIndex, range.indexCount);
+            if (source.primitive->indices)
+            {
+                source.error = source.error ? source.error : decodeIndices(document, *source.primitive->indices, out, jobs);
+            }
+            else
+            {
+                std::iota(out.begin(), out.end(), 0u);
+            }
+
+            if (!source.error && range.mode == GL_TRIANGLES && range.indexCount % 3 == 0)
+            {
+                optimizeTriangles(geometry, range, source);
+            }
+        } });
+    for (const auto &source : sources)
+    {
+        if (source.error)
+        {
+            return "Static batch: " + *source.error;
+        }
+        geometry.cacheBefore += source.cacheBefore;
+        geometry.cacheAfter += source.cacheAfter;
+    }
+
+    for (const auto &[node, transform] : document.getNodeWorldTransforms())
+    {
+        if (auto mesh = document.getNodes()[node].mesh; mesh)
+        {
+            geometry.instances.push_back({transform, *mesh, {}});
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> Core::GLTF::StaticBatch::build(const Document &document, JobSystem &jobs)
+{
+    DecodedGeometry geometry;
+    if (auto error = decode(document, geometry, jobs); error)
+    {
+        return error;
+    }
+    return build(geometry.view());
+}
+
+std::optional<std::string> Core::GLTF::StaticBatch::build(const Geometry &geometry)
+{
+    CORE_TRACE_ZONE("StaticBatch::build");
+    size_t vertexCount = geometry.positions.size() / 3;
+    if (vertexCount == 0 || geometry.indices.empty() || geometry.positions.size() != vertexCount * 3 ||
+        geometry.texCoords.size() != vertexCount * 2 || geometry.normals.size() != vertexCount * 3)
+    {
+        return "Static batch: vertex streams are empty or differ in length";
+    }
+    for (const auto &primitive : geometry.primitives)
+    {
+        if (uint64_t(primitive.firstIndex) + primitive.indexCount > geometry.indices.size() ||
+            uint64_t(primitive.baseVertex) + primitive.vertexCount > vertexCount)
+        {
+            return "Static batch: primitive outside the shared streams";
+        }
+    }
+    const auto &meshPrimitives = geometry.meshPrimitives;
+    if (meshPrimitives.empty() || meshPrimitives.back() != geometry.primitives.size() ||
+        !std::is_sorted(meshPrimitives.begin(), meshPrimitives.end()))
+    {
+        return "Static batch: malformed mesh table";
+    }
+
+    // One command per primitive instance, grouped by mode since each
+    // multi-draw takes a single one
+    struct Draw
+    {
+        GLenum mode;
+        Command command;
+        glm::mat4 transform;
+    };
+    std::vector<Draw> draws;
+    for (const auto &instance : geometry.instances)
+    {
+        if (instance.mesh + size_t(1) >= meshPrimitives.size())
+        {
+            return "Static batch: instance of a missing mesh";
+        }
+        for (size_t i = meshPrimitives[instance.mesh]; i < meshPrimitives[instance.mesh + 1]; ++i)
+        {
+            const auto &primitive = geometry.primitives[i];
+            Command command{primitive.indexCount, 1, primitive.firstIndex, static_cast<GLint>(primitive.baseVertex), 0};
+            draws.push_back({primitive.mode, command, instance.transform});
+        }
+    }
+    if (draws.empty())
+    {
+        return "Document has no mesh instances";
+    }
+    std::stable_sort(draws.begin(), draws.end(), [](const Draw &a, const Draw &b)
+                     { return a.mode < b.mode; });
+
+    // gl_DrawID restarts at zero for every multi-draw, so each mode's
+    // DrawData starts at an offset glBindBufferRange accepts
+    GLint alignment = 0;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    size_t alignedEntries = std::max<size_t>(1, (static_cast<size_t>(std::max(alignment, 1)) + sizeof(DrawData) - 1) / sizeof(DrawData));
+
+    std::vector<Command> commandData;
+    std::vector<DrawData> drawDataEntries;
+    commandData.reserve(draws.size());
+    ranges.clear();
+    for (const auto &draw : draws)
+    {
+        if (ranges.empty() || ranges.back().mode != draw.mode)
+        {
+            drawDataEntries.resize((drawDataEntries.size() + alignedEntries - 1) / alignedEntries * alignedEntries, DrawData{glm::mat4(1.0f)});
+            ranges.push_back({draw.mode, commandData.size(), 0, drawDataEntries.size()});
+        }
+        commandData.push_back(draw.command);
+        drawDataEntries.push_back({draw.transform});
+        ++ranges.back().commandCount;
+    }
+    commandCount = commandData.size();
+
+    std::optional<std::string> error;
+    error = positions.setData(geometry.positions);
+    error = error ? error : texCoords.setData(geometry.texCoords);
+    error = error ? error : normals.setData(geometry.normals);
+    error = error ? error : indices.setData(geometry.indices);
+    error = error ? error : commands.setData(std::span(commandData));
+    error = error ? error : drawData.setData(std::span(drawDataEntries));
+    if (error)
+    {
+        return "Static batch upload: " + *error;
+    }
+
+    vao.addVertexBuffer(positions, 0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    vao.addVertexBuffer(texCoords, 1, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    vao.addVertexBuffer(normals, 2, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    vao.setIndexBuffer(indices);
+
+    return std::nullopt;
+}
+
+void Core::GLTF::StaticBatch::draw(GLuint drawDataBinding) const
+{
+    if (ranges.empty())
+    {
+        return;
+    }
+    CORE_PROFILE_ZONE("StaticBatch::draw");
+
+    auto &state = GL::GLState::current();
+    vao.bind();
+    commands.bind();
+    for (const auto &range : ranges)
+    {
+        state.bindBufferRange(GL_SHADER_STORAGE_BUFFER, drawDataBinding, drawData.getID(),
+                              static_cast<GLintptr>(range.firstData * sizeof(DrawData)),
+                              static_cast<GLsizeiptr>(range.commandCount * sizeof(DrawData)));
+        glMultiDrawElementsIndirect(range.mode, GL_UNSIGNED_INT, reinterpret_cast<const void *>(range.firstCommand * sizeof(Command)),
+                                    range.commandCount, 0);
+    }
+    vao.unbind();
+}
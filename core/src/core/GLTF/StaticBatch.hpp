@@ -0,0 +1,144 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "../GL/GLBuffer.hpp"
+#include "../GL/VAO.hpp"
+#include "../JobSystem.hpp"
+#include "../MeshOptimizer.hpp"
+#include "Document.hpp"
+
+namespace Core::GLTF
+{
+    // Every primitive of a document packed into shared vertex and index
+    // buffers and drawn with one glMultiDrawElementsIndirect per primitive
+    // mode. Each node instance of each primitive is one indirect command;
+    // shaders fetch its transform from the DrawData storage buffer with
+    // gl_DrawID (see assets/shaders/indirect). Only POSITION, TEXCOORD_0 and
+    // NORMAL are kept, missing ones read as zero. Building is split in two:
+    // decode() flattens a document into plain arrays, and build() uploads
+    // those, whether they were just decoded or mapped from a cooked file
+    // (see SceneCache). Decoding also reorders every triangle list for the
+    // post-transform cache, then for overdraw, then renumbers its vertices
+    // for fetch locality (see MeshOptimizer.hpp).
+    class StaticBatch
+    {
+    public:
+        // Layout fixed by the GL
+        struct Command
+        {
+            GLuint count;
+            GLuint instanceCount;
+            GLuint firstIndex;
+            GLint baseVertex;
+            GLuint baseInstance;
+        };
+
+        // std430 layout of one DrawData entry
+        struct DrawData
+        {
+            glm::mat4 transform;
+        };
+
+        // A primitive's slice of the shared streams. Its indices are
+        // relative to baseVertex.
+        struct Primitive
+        {
+            GLenum mode;
+            uint32_t firstIndex;
+            uint32_t indexCount;
+            uint32_t baseVertex;
+            uint32_t vertexCount;
+        };
+
+        // One entry of the flat node table: a mesh placed in the world
+        struct Instance
+        {
+            glm::mat4 transform;
+            uint32_t mesh;
+            uint32_t padding[3];
+        };
+
+        // Everything build() uploads. Views, so the arrays can live in a
+        // DecodedGeometry or straight in a mapped file.
+        struct Geometry
+        {
+            std::span<const float> positions;
+            std::span<const float> texCoords;
+            std::span<const float> normals;
+            std::span<const uint32_t> indices;
+            std::span<const Primitive> primitives;
+            // First primitive of every mesh, followed by the primitive count
+            std::span<const uint32_t> meshPrimitives;
+            std::span<const Instance> instances;
+        };
+
+        struct DecodedGeometry
+        {
+            std::vector<float> positions;
+            std::vector<float> texCoords;
+            std::vector<float> normals;
+            std::vector<uint32_t> indices;
+            std::vector<Primitive> primitives;
+            std::vector<uint32_t> meshPrimitives;
+            std::vector<Instance> instances;
+
+            // Triangle lists as exported and after reordering
+            VertexCacheStatistics cacheBefore;
+            VertexCacheStatistics cacheAfter;
+
+            [[nodiscard]] Geometry view() const noexcept
+            {
+                return {positions, texCoords, normals, indices, primitives, meshPrimitives, instances};
+            }
+        };
+
+    private:
+        struct Range
+        {
+            GLenum mode;
+            size_t firstCommand;
+            GLsizei commandCount;
+            // First DrawData entry, aligned for glBindBufferRange
+            size_t firstData;
+        };
+
+        GL::GLBuffer positions{GL::BufferType::Vertex};
+        GL::GLBuffer texCoords{GL::BufferType::Vertex};
+        GL::GLBuffer normals{GL::BufferType::Vertex};
+        GL::GLBuffer indices{GL::BufferType::Index};
+        GL::GLBuffer commands{GL::BufferType::DrawIndirect};
+        GL::GLBuffer drawData{GL::BufferType::ShaderStorage};
+        GL::VAO vao;
+        std::vector<Range> ranges;
+        size_t commandCount = 0;
+
+    public:
+        StaticBatch() = default;
+
+        // The following prevents copying and moving, the VAO refers to the
+        // member buffers
+        StaticBatch(const StaticBatch &) = delete;
+        StaticBatch &operator=(const StaticBatch &) = delete;
+
+        // Decodes every primitive and node instance of the document
+        static std::optional<std::string> decode(const Document &document, DecodedGeometry &geometry, JobSystem &jobs = JobSystem::shared());
+
+        std::optional<std::string> build(const Document &document, JobSystem &jobs = JobSystem::shared());
+        // Checks that every range lies inside its array before uploading,
+        // since geometry may come from a file
+        std::optional<std::string> build(const Geometry &geometry);
+
+        // DrawData is bound to the given shader storage binding
+        void draw(GLuint drawDataBinding = 0) const;
+
+        [[nodiscard]] size_t getCommandCount() const noexcept { return commandCount; }
+        [[nodiscard]] size_t getDrawCallCount() const noexcept { return ranges.size(); }
+    };
+}
@@ -0,0 +1,199 @@
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <iostream>
+
+#include "Trace.hpp"
+
+namespace
+{
+    // Queue owned by the current thread, or npos on non-worker threads
+    thread_local size_t currentQueue = static_cast<size_t>(-1);
+    thread_local const Core::JobSystem *currentSystem = nullptr;
+}
+
+Core::JobSystem::JobSystem(unsigned threadCount)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    queues.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i)
+    {
+        queues.push_back(std::make_unique<Queue>());
+    }
+
+    workers.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; ++i)
+    {
+        workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+Core::JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard lock(sleepMutex);
+        running = false;
+    }
+    wakeCondition.notify_all();
+
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+Core::JobSystem &Core::JobSystem::shared()
+{
+    static JobSystem system;
+    return system;
+}
+
+void Core::JobSystem::submit(Job job, Counter *counter)
+{
+    if (counter)
+    {
+        counter->pending.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Workers keep their own jobs local, everyone else spreads round-robin
+    size_t index = currentSystem == this ? currentQueue : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    {
+        std::lock_guard lock(queues[index]->mutex);
+        queues[index]->jobs.emplace_back(std::move(job), counter);
+    }
+
+    queuedJobs.fetch_add(1, std::memory_order_release);
+    {
+        // Pairs with the predicate check in workerLoop so a wake is never lost
+        std::lock_guard lock(sleepMutex);
+    }
+    wakeCondition.notify_one();
+}
+
+void Core::JobSystem::wait(Counter &counter)
+{
+    size_t preferred = currentSystem == this ? currentQueue : 0;
+    while (!counter.isDone())
+    {
+        if (!runOne(preferred))
+        {
+            // Remaining jobs are running on other threads
+            std::this_thread::yield();
+        }
+    }
+}
+
+void Core::JobSystem::parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)> &fn)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    grainSize = std::max<size_t>(grainSize, 1);
+    // A few chunks per worker leaves room for stealing to balance the load
+    size_t maxChunks = (workers.size() + 1) * 4;
+    size_t chunkSize = std::max(grainSize, (count + maxChunks - 1) / maxChunks);
+    if (chunkSize >= count)
+    {
+        fn(0, count);
+        return;
+    }
+
+    Counter counter;
+    for (size_t begin = chunkSize; begin < count; begin += chunkSize)
+    {
+        size_t end = std::min(count, begin + chunkSize);
+        submit([&fn, begin, end]
+               { fn(begin, end); },
+               &counter);
+    }
+    // The caller takes the first chunk itself
+    fn(0, chunkSize);
+    wait(counter);
+}
+
+void Core::JobSystem::workerLoop(size_t index)
+{
+    currentQueue = index;
+    currentSystem = this;
+#ifdef CORE_PROFILER
+    Trace::setThreadName("JobSystem worker");
+#endif
+
+    while (true)
+    {
+        if (runOne(index))
+        {
+            continue;
+        }
+
+        std::unique_lock lock(sleepMutex);
+        wakeCondition.wait(lock, [this]
+                           { return !running || queuedJobs.load(std::memory_order_acquire) > 0; });
+        if (!running && queuedJobs.load(std::memory_order_acquire) == 0)
+        {
+            return;
+        }
+    }
+}
+
+bool Core::JobSystem::runOne(size_t preferredQueue)
+{
+    std::pair<Job, Counter *> item;
+    bool found = false;
+
+    // Own queue first, newest job for cache locality
+    {
+        auto &own = *queues[preferredQueue];
+        std::lock_guard lock(own.mutex);
+        if (!own.jobs.empty())
+        {
+            item = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            found = true;
+        }
+    }
+
+    // Then steal the oldest job from someone else
+    for (size_t i = 1; !found && i < queues.size(); ++i)
+    {
+        auto &victim = *queues[(preferredQueue + i) % queues.size()];
+        std::unique_lock lock(victim.mutex, std::try_to_lock);
+        if (lock.owns_lock() && !victim.jobs.empty())
+        {
+            item = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            found = true;
+        }
+    }
+
+    if (!found)
+    {
+        return false;
+    }
+
+    queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    try
+    {
+        item.first();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Job threw an exception: " << e.what() << '\n';
+    }
+    finish(item.second);
+    return true;
+}
+
+void Core::JobSystem::finish(Counter *counter) noexcept
+{
+    if (counter)
+    {
+        counter->pending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Core
+{
+    // Work-stealing thread pool. Each worker owns a deque it pushes to and
+    // pops from at the back; idle workers steal from the front of the others.
+    // Threads that wait on a counter run queued jobs instead of blocking, so
+    // jobs may freely submit and wait on nested work.
+    class JobSystem
+    {
+    public:
+        using Job = std::function<void()>;
+
+        // Tracks a group of jobs, reaches zero once all of them have run
+        class Counter
+        {
+        private:
+            friend class JobSystem;
+            std::atomic<size_t> pending{0};
+
+        public:
+            [[nodiscard]] bool isDone() const noexcept { return pending.load(std::memory_order_acquire) == 0; }
+        };
+
+    private:
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<std::pair<Job, Counter *>> jobs;
+        };
+
+        std::vector<std::unique_ptr<Queue>> queues;
+        std::vector<std::thread> workers;
+        std::atomic<size_t> queuedJobs{0};
+        std::atomic<size_t> nextQueue{0};
+        std::atomic<bool> running{true};
+        std::mutex sleepMutex;
+        std::condition_variable wakeCondition;
+
+    public:
+        // Zero picks one worker per hardware thread
+        explicit JobSystem(unsigned threadCount = 0);
+        ~JobSystem();
+
+        JobSystem(const JobSystem &) = delete;
+        JobSystem &operator=(const JobSystem &) = delete;
+
+        // Process-wide pool, created on first use
+        static JobSystem &shared();
+
+        void submit(Job job, Counter *counter = nullptr);
+
+        // Runs queued jobs on the calling thread until the counter reaches zero
+        void wait(Counter &counter);
+
+        // Splits [0, count) into chunks of at least grainSize and runs
+        // fn(begin, end) for each across the pool, returning once all are done
+        void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t, size_t)> &fn);
+
+        [[nodiscard]] size_t getWorkerCount() const noexcept { return workers.size(); }
+
+    private:
+        void workerLoop(size_t index);
+        bool runOne(size_t preferredQueue);
+        static void finish(Counter *counter) noexcept;
+    };
+}
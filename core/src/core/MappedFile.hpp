@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <optional>
+
+namespace Core
+{
+    // Read-only memory mapping of a whole file. The mapped bytes stay valid
+    // for the lifetime of the object, so views into them can be handed
+    // straight to the GL without an intermediate copy.
+    class MappedFile
+    {
+    private:
+        const std::byte *data = nullptr;
+        size_t size = 0;
+#ifdef _WIN32
+        void *fileHandle = nullptr;
+        void *mappingHandle = nullptr;
+#endif
+
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        // The following prevents copying, but allows moving
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+        MappedFile(MappedFile &&other) noexcept;
+        MappedFile &operator=(MappedFile &&other) noexcept;
+
+        std::optional<std::string> open(const std::string &path);
+        void close();
+
+        [[nodiscard]] bool isOpen() const noexcept { return data != nullptr; }
+        [[nodiscard]] std::span<const std::byte> getData() const noexcept { return {data, size}; }
+        [[nodiscard]] size_t getSize() const noexcept { return size; }
+    };
+}
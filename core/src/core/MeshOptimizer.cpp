@@ -0,0 +1,461 @@
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+
+namespace
+{
+    // Size of the LRU cache the Forsyth scores model. Larger than any real
+    // post-transform cache so the ordering suits a range of GPUs.
+    constexpr size_t forsythCacheSize = 32;
+    constexpr size_t forsythMaxValence = 32;
+    constexpr float lastTriangleScore = 0.75f;
+    constexpr float cacheDecayPower = 1.5f;
+    constexpr float valenceBoostScale = 2.0f;
+    constexpr float valenceBoostPower = 0.5f;
+
+    constexpr uint32_t noTriangle = UINT32_MAX;
+
+    // FIFO size for the overdraw clustering, as for analyzeVertexCache
+    constexpr size_t overdrawCacheSize = 16;
+
+    struct ScoreTables
+    {
+        std::array<float, forsythCacheSize> cache;
+        std::array<float, forsythMaxValence + 1> valence;
+    };
+
+    const ScoreTables &scoreTables()
+    {
+        static const ScoreTables tables = []
+        {
+            ScoreTables result{};
+            for (size_t i = 0; i < forsythCacheSize; ++i)
+            {
+                // The three vertices of the last triangle get a fixed score
+                // so it is not simply repeated in another winding
+                result.cache[i] = i < 3 ? lastTriangleScore
+                                        : std::pow(1.0f - float(i - 3) / float(forsythCacheSize - 3), cacheDecayPower);
+            }
+            for (size_t i = 1; i <= forsythMaxValence; ++i)
+            {
+                // Vertices with few triangles left are worth finishing off
+                result.valence[i] = valenceBoostScale * std::pow(float(i), -valenceBoostPower);
+            }
+            return result;
+        }();
+        return tables;
+    }
+
+    float vertexScore(const ScoreTables &tables, int cachePosition, uint32_t liveTriangles) noexcept
+    {
+        if (liveTriangles == 0)
+        {
+            return -1.0f;
+        }
+        float score = cachePosition >= 0 ? tables.cache[cachePosition] : 0.0f;
+        return score + tables.valence[std::min<size_t>(liveTriangles, forsythMaxValence)];
+    }
+
+    template <typename Index>
+    bool indicesInRange(std::span<const Index> indices, size_t vertexCount) noexcept
+    {
+        return std::all_of(indices.begin(), indices.end(), [&](Index index)
+                           { return index < vertexCount; });
+    }
+
+    // FIFO cache where a vertex is resident while fewer than size misses
+    // have happened since it was loaded. Advancing the clock by more than
+    // size empties it.
+    class FifoCache
+    {
+    private:
+        std::vector<uint64_t> loadedAt;
+        uint64_t clock;
+        size_t size;
+
+    public:
+        FifoCache(size_t vertexCount, size_t cacheSize)
+            : loadedAt(vertexCount, 0), clock(cacheSize + 1), size(cacheSize) {}
+
+        bool isNew(uint32_t vertex) const noexcept { return loadedAt[vertex] == 0; }
+
+        // Returns whether the vertex missed
+        bool access(uint32_t vertex) noexcept
+        {
+            if (clock - loadedAt[vertex] <= size)
+            {
+                return false;
+            }
+            loadedAt[vertex] = clock++;
+            return true;
+        }
+
+        template <typename Index>
+        unsigned accessTriangle(const Index *triangle) noexcept
+        {
+            return unsigned(access(triangle[0])) + unsigned(access(triangle[1])) + unsigned(access(triangle[2]));
+        }
+
+        void clear() noexcept { clock += size + 1; }
+    };
+
+    // Written for both index widths, so uint16 lists are handled without a
+    // widened copy
+
+    template <typename Index>
+    Core::VertexCacheStatistics analyzeIndices(std::span<const Index> indices, size_t vertexCount, size_t cacheSize)
+    {
+        Core::VertexCacheStatistics statistics;
+        FifoCache cache(vertexCount, cacheSize);
+        for (uint32_t index : indices)
+        {
+            if (index >= vertexCount)
+            {
+                continue;
+            }
+            statistics.vertices += cache.isNew(index);
+            statistics.misses += cache.access(index);
+        }
+        statistics.triangles = indices.size() / 3;
+        return statistics;
+    }
+
+    template <typename Index>
+    void optimizeCacheOrder(std::span<Index> indices, size_t vertexCount)
+    {
+        size_t triangleCount = indices.size() / 3;
+        if (triangleCount < 2 || !indicesInRange<Index>(indices, vertexCount))
+        {
+            return;
+        }
+        const ScoreTables &tables = scoreTables();
+
+        // Triangles using each vertex, packed per vertex. The first live[v]
+        // entries of a vertex's range are the triangles not yet emitted.
+        std::vector<uint32_t> live(vertexCount, 0);
+        for (size_t i = 0; i < triangleCount * 3; ++i)
+        {
+            ++live[indices[i]];
+        }
+        std::vector<uint32_t> offsets(vertexCount + 1, 0);
+        std::inclusive_scan(live.begin(), live.end(), offsets.begin() + 1);
+        std::vector<uint32_t> adjacency(triangleCount * 3);
+        {
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < triangleCount * 3; ++i)
+            {
+                adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+            }
+        }
+
+        std::vector<int> cachePosition(vertexCount, -1);
+        std::vector<float> scores(vertexCount);
+        for (size_t v = 0; v < vertexCount; ++v)
+        {
+            scores[v] = vertexScore(tables, -1, live[v]);
+        }
+
+        auto triangleScore = [&](uint32_t triangle)
+        {
+            const Index *corners = &indices[triangle * 3];
+            return scores[corners[0]] + scores[corners[1]] + scores[corners[2]];
+        };
+
+        // Start from the best triangle overall, usually one on a boundary
+        uint32_t best = 0;
+        float bestScore = triangleScore(0);
+        for (uint32_t triangle = 1; triangle < triangleCount; ++triangle)
+        {
+            if (float score = triangleScore(triangle); score > bestScore)
+            {
+                best = triangle;
+                bestScore = score;
+            }
+        }
+
+        std::vector<Index> output(triangleCount * 3);
+        std::vector<uint8_t> emitted(triangleCount, 0);
+        std::array<uint32_t, forsythCacheSize + 3> cache{};
+        size_t cacheCount = 0;
+        size_t cursor = 0;
+        for (size_t written = 0; written < triangleCount; ++written)
+        {
+            if (best == noTriangle)
+            {
+                // Nothing left around the cache, carry on with the next
+                // triangle in input order
+                while (emitted[cursor])
+                {
+                    ++cursor;
+                }
+                best = static_cast<uint32_t>(cursor);
+            }
+
+            const uint32_t corners[3] = {indices[best * 3], indices[best * 3 + 1], indices[best * 3 + 2]};
+            std::copy(corners, corners + 3, output.begin() + written * 3);
+            emitted[best] = 1;
+            for (uint32_t vertex : corners)
+            {
+                uint32_t *begin = adjacency.data() + offsets[vertex];
+                uint32_t *end = begin + live[vertex];
+                *std::find(begin, end, best) = *(end - 1);
+                --live[vertex];
+            }
+
+            // The triangle's vertices move to the front, the rest shift back and
+            // whatever passes the end is evicted
+            std::array<uint32_t, forsythCacheSize + 3> next;
+            size_t nextCount = 0;
+            for (uint32_t vertex : corners)
+            {
+                if (std::find(next.begin(), next.begin() + nextCount, vertex) == next.begin() + nextCount)
+                {
+                    next[nextCount++] = vertex;
+                }
+            }
+            for (size_t i = 0; i < cacheCount; ++i)
+            {
+                uint32_t vertex = cache[i];
+                if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2])
+                {
+                    next[nextCount++] = vertex;
+                }
+            }
+            for (size_t i = 0; i < nextCount; ++i)
+            {
+                uint32_t vertex = next[i];
+                cachePosition[vertex] = i < forsythCacheSize ? static_cast<int>(i) : -1;
+                scores[vertex] = vertexScore(tables, cachePosition[vertex], live[vertex]);
+            }
+            cacheCount = std::min(nextCount, forsythCacheSize);
+            std::copy(next.begin(), next.begin() + cacheCount, cache.begin());
+
+            // Only triangles touching the cache changed score enough to win
+            best = noTriangle;
+            bestScore = -1.0f;
+            for (size_t i = 0; i < cacheCount; ++i)
+            {
+                uint32_t vertex = cache[i];
+                const uint32_t *triangles = adjacency.data() + offsets[vertex];
+                for (uint32_t j = 0; j < live[vertex]; ++j)
+                {
+                    if (float score = triangleScore(triangles[j]); score > bestScore)
+                    {
+                        best = triangles[j];
+                        bestScore = score;
+                    }
+                }
+            }
+        }
+
+        std::copy(output.begin(), output.end(), indices.begin());
+    }
+
+    template <typename Index>
+    void optimizeOverdrawOrder(std::span<Index> indices, std::span<const float> positions, float threshold)
+    {
+        size_t vertexCount = positions.size() / 3;
+        size_t triangleCount = indices.size() / 3;
+        if (triangleCount < 2 || !indicesInRange<Index>(indices, vertexCount))
+        {
+            return;
+        }
+
+        // Hard boundaries: triangles whose three vertices all miss, where the
+        // cache effectively starts over and splitting costs nothing
+        FifoCache cache(vertexCount, overdrawCacheSize);
+        std::vector<size_t> hard;
+        for (size_t triangle = 0; triangle < triangleCount; ++triangle)
+        {
+            if (cache.accessTriangle(&indices[triangle * 3]) == 3 || triangle == 0)
+            {
+                hard.push_back(triangle);
+            }
+        }
+        hard.push_back(triangleCount);
+
+        // Soft boundaries: within each hard cluster, a cluster ends as soon as
+        // its own ACMR, measured from a cold cache, reaches threshold times that
+        // of the hard cluster
+        std::vector<size_t> clusters;
+        for (size_t i = 0; i + 1 < hard.size(); ++i)
+        {
+            size_t begin = hard[i];
+            size_t end = hard[i + 1];
+
+            cache.clear();
+            size_t misses = 0;
+            for (size_t triangle = begin; triangle < end; ++triangle)
+            {
+                misses += cache.accessTriangle(&indices[triangle * 3]);
+            }
+            double limit = threshold * double(misses) / double(end - begin);
+
+            cache.clear();
+            clusters.push_back(begin);
+            size_t runningMisses = 0;
+            size_t runningTriangles = 0;
+            for (size_t triangle = begin; triangle < end; ++triangle)
+            {
+                runningMisses += cache.accessTriangle(&indices[triangle * 3]);
+                ++runningTriangles;
+                if (double(runningMisses) <= limit * double(runningTriangles) && triangle + 1 < end)
+                {
+                    clusters.push_back(triangle + 1);
+                    cache.clear();
+                    runningMisses = 0;
+                    runningTriangles = 0;
+                }
+            }
+        }
+        clusters.push_back(triangleCount);
+        size_t clusterCount = clusters.size() - 1;
+        if (clusterCount < 2)
+        {
+            return;
+        }
+
+        // Area weighted centroid and normal of every cluster and of the mesh
+        auto vertex = [&](uint32_t index)
+        {
+            const float *p = &positions[size_t(index) * 3];
+            return std::array<double, 3>{p[0], p[1], p[2]};
+        };
+        struct Cluster
+        {
+            std::array<double, 3> centroid{};
+            std::array<double, 3> normal{};
+            double area = 0.0;
+        };
+        std::vector<Cluster> data(clusterCount);
+        Cluster mesh;
+        for (size_t c = 0; c < clusterCount; ++c)
+        {
+            Cluster &cluster = data[c];
+            for (size_t triangle = clusters[c]; triangle < clusters[c + 1]; ++triangle)
+            {
+                auto a = vertex(indices[triangle * 3]);
+                auto b = vertex(indices[triangle * 3 + 1]);
+                auto d = vertex(indices[triangle * 3 + 2]);
+                std::array<double, 3> u{b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+                std::array<double, 3> w{d[0] - a[0], d[1] - a[1], d[2] - a[2]};
+                std::array<double, 3> n{u[1] * w[2] - u[2] * w[1], u[2] * w[0] - u[0] * w[2], u[0] * w[1] - u[1] * w[0]};
+                double area = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                for (int k = 0; k < 3; ++k)
+                {
+                    cluster.centroid[k] += (a[k] + b[k] + d[k]) / 3.0 * area;
+                    cluster.normal[k] += n[k];
+                }
+                cluster.area += area;
+            }
+            for (int k = 0; k < 3; ++k)
+            {
+                mesh.centroid[k] += cluster.centroid[k];
+            }
+            mesh.area += cluster.area;
+        }
+        if (mesh.area <= 0.0)
+        {
+            return;
+        }
+
+        std::vector<double> keys(clusterCount, 0.0);
+        for (size_t c = 0; c < clusterCount; ++c)
+        {
+            const Cluster &cluster = data[c];
+            double length = std::sqrt(cluster.normal[0] * cluster.normal[0] + cluster.normal[1] * cluster.normal[1] + cluster.normal[2] * cluster.normal[2]);
+            if (cluster.area <= 0.0 || length <= 0.0)
+            {
+                continue;
+            }
+            for (int k = 0; k < 3; ++k)
+            {
+                keys[c] += (cluster.centroid[k] / cluster.area - mesh.centroid[k] / mesh.area) * cluster.normal[k] / length;
+            }
+        }
+
+        std::vector<size_t> order(clusterCount);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b)
+                         { return keys[a] > keys[b]; });
+
+        std::vector<Index> output;
+        output.reserve(triangleCount * 3);
+        for (size_t c : order)
+        {
+            output.insert(output.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+        }
+        std::copy(output.begin(), output.end(), indices.begin());
+    }
+}
+
+Core::VertexCacheStatistics Core::analyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, size_t cacheSize)
+{
+    return analyzeIndices(indices, vertexCount, cacheSize);
+}
+
+Core::VertexCacheStatistics Core::analyzeVertexCache(std::span<const uint16_t> indices, size_t vertexCount, size_t cacheSize)
+{
+    return analyzeIndices(indices, vertexCount, cacheSize);
+}
+
+void Core::optimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount)
+{
+    optimizeCacheOrder(indices, vertexCount);
+}
+
+void Core::optimizeVertexCache(std::span<uint16_t> indices, size_t vertexCount)
+{
+    optimizeCacheOrder(indices, vertexCount);
+}
+
+void Core::optimizeOverdraw(std::span<uint32_t> indices, std::span<const float> positions, float threshold)
+{
+    optimizeOverdrawOrder(indices, positions, threshold);
+}
+
+void Core::optimizeOverdraw(std::span<uint16_t> indices, std::span<const float> positions, float threshold)
+{
+    optimizeOverdrawOrder(indices, positions, threshold);
+}
+
+std::vector<uint32_t> Core::optimizeVertexFetch(std::span<uint32_t> indices, size_t vertexCount)
+{
+    std::vector<uint32_t> remap(vertexCount);
+    if (!indicesInRange<uint32_t>(indices, vertexCount))
+    {
+        std::iota(remap.begin(), remap.end(), 0u);
+        return remap;
+    }
+
+    std::fill(remap.begin(), remap.end(), UINT32_MAX);
+    uint32_t next = 0;
+    for (uint32_t &index : indices)
+    {
+        if (remap[index] == UINT32_MAX)
+        {
+            remap[index] = next++;
+        }
+        index = remap[index];
+    }
+    for (uint32_t &slot : remap)
+    {
+        if (slot == UINT32_MAX)
+        {
+            slot = next++;
+        }
+    }
+    return remap;
+}
+
+void Core::remapVertices(std::span<float> vertices, size_t components, std::span<const uint32_t> remap)
+{
+    std::vector<float> original(vertices.begin(), vertices.end());
+    for (size_t v = 0; v < remap.size(); ++v)
+    {
+        std::copy_n(original.begin() + v * components, components, vertices.begin() + size_t(remap[v]) * components);
+    }
+}
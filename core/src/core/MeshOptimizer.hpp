@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Core
+{
+    // Post-transform vertex cache behaviour of an index buffer, from a FIFO
+    // cache simulation. Counts add up across meshes.
+    struct VertexCacheStatistics
+    {
+        size_t triangles = 0;
+        size_t vertices = 0; // distinct vertices referenced
+        size_t misses = 0;   // vertex shader invocations
+
+        // Average cache miss ratio: shaded vertices per triangle, 0.5 at
+        // best on a regular grid and 3 with no reuse at all
+        [[nodiscard]] double getACMR() const noexcept { return triangles ? double(misses) / double(triangles) : 0.0; }
+        // Average transformed vertex ratio: times each vertex is shaded, 1 at best
+        [[nodiscard]] double getATVR() const noexcept { return vertices ? double(misses) / double(vertices) : 0.0; }
+
+        VertexCacheStatistics &operator+=(const VertexCacheStatistics &other) noexcept
+        {
+            triangles += other.triangles;
+            vertices += other.vertices;
+            misses += other.misses;
+            return *this;
+        }
+    };
+
+    [[nodiscard]] VertexCacheStatistics analyzeVertexCache(std::span<const uint32_t> indices, size_t vertexCount, size_t cacheSize = 16);
+    [[nodiscard]] VertexCacheStatistics analyzeVertexCache(std::span<const uint16_t> indices, size_t vertexCount, size_t cacheSize = 16);
+
+    // Reorders the triangles of an indexed triangle list for vertex reuse
+    // with Tom Forsyth's linear-speed algorithm: every vertex is scored by
+    // its position in a simulated LRU cache plus a bonus for having few
+    // triangles left, and the live triangle with the best summed score among
+    // those touching the cache is emitted next.
+    void optimizeVertexCache(std::span<uint32_t> indices, size_t vertexCount);
+    void optimizeVertexCache(std::span<uint16_t> indices, size_t vertexCount);
+
+    // Reorders clusters of an already cache-optimised triangle list to cut
+    // overdraw, after Sander, Nehab and Barczak's "Fast Triangle Reordering
+    // for Vertex Locality and Reduced Overdraw". The list is split where the
+    // simulated cache starts cold, and further wherever a cluster's ACMR has
+    // fallen to threshold times that of its parent, so cache efficiency
+    // worsens by at most that factor. Clusters facing away from the mesh
+    // centre are then drawn first, as they tend to occlude the rest.
+    // Positions are xyz triplets.
+    void optimizeOverdraw(std::span<uint32_t> indices, std::span<const float> positions, float threshold = 1.05f);
+    void optimizeOverdraw(std::span<uint16_t> indices, std::span<const float> positions, float threshold = 1.05f);
+
+    // Renumbers vertices in the order the indices first use them, so vertex
+    // fetch walks memory forward. Rewrites the indices and returns the
+    // mapping from old to new vertex, with unreferenced vertices moved to
+    // the end; apply it to every vertex stream with remapVertices.
+    [[nodiscard]] std::vector<uint32_t> optimizeVertexFetch(std::span<uint32_t> indices, size_t vertexCount);
+
+    // Moves each vertex of a stream with the given number of components
+    // per vertex to its slot in remap
+    void remapVertices(std::span<float> vertices, size_t components, std::span<const uint32_t> remap);
+}
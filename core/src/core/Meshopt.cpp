@@ -0,0 +1,938 @@
+#include "Meshopt.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define CORE_MESHOPT_SSE2 1
+#endif
+// The pshufb vertex decoder is compiled for SSSE3 whatever the build flags
+// and only taken when the CPU has it
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <tmmintrin.h>
+#define CORE_MESHOPT_SSSE3 1
+#endif
+
+namespace
+{
+    constexpr uint8_t vertexHeader = 0xA0;
+    constexpr uint8_t triangleHeader = 0xE0;
+    constexpr uint8_t sequenceHeader = 0xD0;
+    constexpr int vertexVersion = 0;
+    constexpr int indexVersion = 1;
+
+    // A block holds as many vertices as fit in 8 KiB, in multiples of 16
+    constexpr size_t vertexBlockSizeBytes = 8192;
+    constexpr size_t vertexBlockMaxSize = 256;
+    constexpr size_t byteGroupSize = 16;
+    // Most a group can read: 8 bytes of 4-bit values and 16 escaped bytes
+    constexpr size_t byteGroupDecodeLimit = 24;
+    // The first vertex is stored at the end, padded to at least this size,
+    // which keeps the group reads above inside the stream
+    constexpr size_t vertexTailMinSize = 32;
+    // Bytes the triangle codec keeps at the end for its code table
+    constexpr size_t triangleTailSize = 16;
+    // Bytes the index sequence codec pads its end with
+    constexpr size_t sequenceTailSize = 4;
+
+    using Bytes = const uint8_t *;
+
+    size_t vertexBlockSize(size_t stride) noexcept
+    {
+        return std::min((vertexBlockSizeBytes / stride) & ~(byteGroupSize - 1), vertexBlockMaxSize);
+    }
+
+    // Whether a buffer of bytes holds exactly count elements of size bytes,
+    // checked without the product wrapping around
+    bool holdsExactly(size_t bytes, size_t count, size_t size) noexcept
+    {
+        return size != 0 && count <= bytes / size && bytes == count * size;
+    }
+
+    uint8_t unzigzag8(uint8_t value) noexcept
+    {
+        return static_cast<uint8_t>(-(value & 1) ^ (value >> 1));
+    }
+
+    // Expands a group of 16 values of 0, 2, 4 or 8 bits. Packed values are
+    // read high bits first, and a value with all bits set is an escape for
+    // a full byte that follows the packed ones.
+    Bytes decodeGroupScalar(Bytes data, uint8_t *out, int bitsLog2) noexcept
+    {
+        switch (bitsLog2)
+        {
+        case 0:
+            std::memset(out, 0, byteGroupSize);
+            return data;
+        case 1:
+        case 2:
+        {
+            int bits = bitsLog2 == 1 ? 2 : 4;
+            int escape = (1 << bits) - 1;
+            int perByte = 8 / bits;
+            Bytes escaped = data + byteGroupSize / size_t(perByte);
+            for (size_t i = 0; i < byteGroupSize; ++i)
+            {
+                int shift = 8 - bits * (int(i % size_t(perByte)) + 1);
+                int value = (data[i / size_t(perByte)] >> shift) & escape;
+                out[i] = value == escape ? *escaped++ : static_cast<uint8_t>(value);
+            }
+            return escaped;
+        }
+        default:
+            std::memcpy(out, data, byteGroupSize);
+            return data + byteGroupSize;
+        }
+    }
+
+#if defined(CORE_MESHOPT_SSSE3)
+    // For each mask of escaped lanes out of eight, the pshufb control that
+    // moves the escaped bytes into them in order, and how many there are
+    struct GroupShuffle
+    {
+        std::array<std::array<uint8_t, 8>, 256> shuffle{};
+        std::array<uint8_t, 256> count{};
+    };
+
+    constexpr GroupShuffle groupShuffle = []
+    {
+        GroupShuffle table;
+        for (int mask = 0; mask < 256; ++mask)
+        {
+            uint8_t next = 0;
+            for (int lane = 0; lane < 8; ++lane)
+            {
+                table.shuffle[mask][lane] = (mask >> lane) & 1 ? next++ : 0x80;
+            }
+            table.count[mask] = next;
+        }
+        return table;
+    }();
+
+    // Reads 16 bytes of escapes no matter how many there are, which the
+    // group decode limit allows for
+    __attribute__((target("ssse3"))) Bytes decodeGroupSimd(Bytes data, uint8_t *out, int bitsLog2) noexcept
+    {
+        __m128i values;
+        size_t packedSize;
+        switch (bitsLog2)
+        {
+        case 0:
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_setzero_si128());
+            return data;
+        case 1:
+        {
+            int32_t packed;
+            std::memcpy(&packed, data, sizeof(packed));
+            // Each step puts the high half of a byte's values before the low
+            // half; bits from the neighbouring byte land above the kept ones
+            __m128i pairs = _mm_cvtsi32_si128(packed);
+            pairs = _mm_unpacklo_epi8(_mm_srli_epi16(pairs, 4), pairs);
+            pairs = _mm_unpacklo_epi8(_mm_srli_epi16(pairs, 2), pairs);
+            values = _mm_and_si128(pairs, _mm_set1_epi8(3));
+            packedSize = 4;
+            break;
+        }
+        case 2:
+        {
+            __m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(data));
+            packed = _mm_unpacklo_epi8(_mm_srli_epi16(packed, 4), packed);
+            values = _mm_and_si128(packed, _mm_set1_epi8(15));
+            packedSize = 8;
+            break;
+        }
+        default:
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out), _mm_loadu_si128(reinterpret_cast<const __m128i *>(data)));
+            return data + byteGroupSize;
+        }
+
+        __m128i escape = _mm_set1_epi8(static_cast<char>(bitsLog2 == 1 ? 3 : 15));
+        __m128i isEscape = _mm_cmpeq_epi8(values, escape);
+        int mask = _mm_movemask_epi8(isEscape);
+        int low = mask & 0xFF;
+        int high = mask >> 8;
+
+        // The upper eight lanes continue from where the lower ones stopped;
+        // the offset keeps the 0x80 of unescaped lanes negative
+        __m128i lowShuffle = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(groupShuffle.shuffle[low].data()));
+        __m128i highShuffle = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(groupShuffle.shuffle[high].data()));
+        highShuffle = _mm_add_epi8(highShuffle, _mm_set1_epi8(static_cast<char>(groupShuffle.count[low])));
+        __m128i shuffle = _mm_unpacklo_epi64(lowShuffle, highShuffle);
+
+        __m128i rest = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + packedSize));
+        __m128i result = _mm_or_si128(_mm_shuffle_epi8(rest, shuffle), _mm_andnot_si128(isEscape, values));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), result);
+        return data + packedSize + groupShuffle.count[low] + groupShuffle.count[high];
+    }
+#endif
+
+    // One byte of every vertex in a block: a header of 2 bits per group
+    // giving its width, then the groups
+    Bytes decodeBytes(Bytes data, Bytes end, uint8_t *out, size_t size) noexcept
+    {
+        size_t groups = size / byteGroupSize;
+        size_t headerSize = (groups + 3) / 4;
+        if (size_t(end - data) < headerSize)
+        {
+            return nullptr;
+        }
+        Bytes header = data;
+        data += headerSize;
+
+        for (size_t group = 0; group < groups; ++group)
+        {
+            if (size_t(end - data) < byteGroupDecodeLimit)
+            {
+                return nullptr;
+            }
+            int bitsLog2 = (header[group / 4] >> ((group % 4) * 2)) & 3;
+            data = decodeGroupScalar(data, out + group * byteGroupSize, bitsLog2);
+        }
+        return data;
+    }
+
+    // Deltas are against the same byte of the previous vertex, with the
+    // vertex before the block carried in `last`
+    Bytes decodeBlockScalar(Bytes data, Bytes end, uint8_t *out, size_t count, size_t stride, uint8_t *last) noexcept
+    {
+        uint8_t buffer[vertexBlockMaxSize];
+        size_t alignedCount = (count + byteGroupSize - 1) & ~(byteGroupSize - 1);
+        for (size_t k = 0; k < stride; ++k)
+        {
+            data = decodeBytes(data, end, buffer, alignedCount);
+            if (!data)
+            {
+                return nullptr;
+            }
+            uint8_t previous = last[k];
+            for (size_t i = 0; i < count; ++i)
+            {
+                previous = static_cast<uint8_t>(unzigzag8(buffer[i]) + previous);
+                out[i * stride + k] = previous;
+            }
+        }
+        std::memcpy(last, out + (count - 1) * stride, stride);
+        return data;
+    }
+
+#if defined(CORE_MESHOPT_SSSE3)
+    // decodeBytes with the pshufb group decoder
+    __attribute__((target("ssse3"))) Bytes decodeBytesSimd(Bytes data, Bytes end, uint8_t *out, size_t size) noexcept
+    {
+        size_t groups = size / byteGroupSize;
+        size_t headerSize = (groups + 3) / 4;
+        if (size_t(end - data) < headerSize)
+        {
+            return nullptr;
+        }
+        Bytes header = data;
+        data += headerSize;
+
+        for (size_t group = 0; group < groups; ++group)
+        {
+            if (size_t(end - data) < byteGroupDecodeLimit)
+            {
+                return nullptr;
+            }
+            int bitsLog2 = (header[group / 4] >> ((group % 4) * 2)) & 3;
+            data = decodeGroupSimd(data, out + group * byteGroupSize, bitsLog2);
+        }
+        return data;
+    }
+
+    __attribute__((target("ssse3"))) __m128i unzigzag8(__m128i value) noexcept
+    {
+        __m128i odd = _mm_cmpeq_epi8(_mm_and_si128(value, _mm_set1_epi8(1)), _mm_set1_epi8(1));
+        __m128i half = _mm_and_si128(_mm_srli_epi16(value, 1), _mm_set1_epi8(0x7F));
+        return _mm_xor_si128(half, odd);
+    }
+
+    // Four bytes of each of four vertices: deltas summed across the lanes,
+    // on top of the vertex before them in every lane of previous
+    __attribute__((target("ssse3"))) __m128i prefixVertices(__m128i deltas, __m128i &previous) noexcept
+    {
+        __m128i sums = unzigzag8(deltas);
+        sums = _mm_add_epi8(sums, _mm_slli_si128(sums, 4));
+        sums = _mm_add_epi8(sums, _mm_slli_si128(sums, 8));
+        sums = _mm_add_epi8(sums, previous);
+        previous = _mm_shuffle_epi32(sums, 0xFF);
+        return sums;
+    }
+
+    // Decodes four byte streams at a time, transposes 16 vertices of them
+    // to vertex order and undoes the deltas a vertex per 32-bit lane
+    __attribute__((target("ssse3"))) Bytes decodeBlockSimd(Bytes data, Bytes end, uint8_t *out, size_t count, size_t stride, uint8_t *last) noexcept
+    {
+        alignas(16) uint8_t buffer[4][vertexBlockMaxSize];
+        alignas(16) uint8_t transposed[byteGroupSize * 4];
+        size_t alignedCount = (count + byteGroupSize - 1) & ~(byteGroupSize - 1);
+        for (size_t k = 0; k < stride; k += 4)
+        {
+            for (size_t channel = 0; channel < 4; ++channel)
+            {
+                data = decodeBytesSimd(data, end, buffer[channel], alignedCount);
+                if (!data)
+                {
+                    return nullptr;
+                }
+            }
+
+            int32_t lastBytes;
+            std::memcpy(&lastBytes, last + k, sizeof(lastBytes));
+            __m128i previous = _mm_set1_epi32(lastBytes);
+            for (size_t i = 0; i < count; i += byteGroupSize)
+            {
+                __m128i r0 = _mm_load_si128(reinterpret_cast<const __m128i *>(buffer[0] + i));
+                __m128i r1 = _mm_load_si128(reinterpret_cast<const __m128i *>(buffer[1] + i));
+                __m128i r2 = _mm_load_si128(reinterpret_cast<const __m128i *>(buffer[2] + i));
+                __m128i r3 = _mm_load_si128(reinterpret_cast<const __m128i *>(buffer[3] + i));
+                __m128i t0 = _mm_unpacklo_epi8(r0, r1);
+                __m128i t1 = _mm_unpackhi_epi8(r0, r1);
+                __m128i t2 = _mm_unpacklo_epi8(r2, r3);
+                __m128i t3 = _mm_unpackhi_epi8(r2, r3);
+
+                auto *target = reinterpret_cast<__m128i *>(transposed);
+                _mm_store_si128(target + 0, prefixVertices(_mm_unpacklo_epi16(t0, t2), previous));
+                _mm_store_si128(target + 1, prefixVertices(_mm_unpackhi_epi16(t0, t2), previous));
+                _mm_store_si128(target + 2, prefixVertices(_mm_unpacklo_epi16(t1, t3), previous));
+                _mm_store_si128(target + 3, prefixVertices(_mm_unpackhi_epi16(t1, t3), previous));
+
+                // Lanes past the end of the block carry garbage and are dropped
+                size_t valid = std::min(byteGroupSize, count - i);
+                for (size_t v = 0; v < valid; ++v)
+                {
+                    std::memcpy(out + (i + v) * stride + k, transposed + v * 4, 4);
+                }
+            }
+        }
+        std::memcpy(last, out + (count - 1) * stride, stride);
+        return data;
+    }
+#endif
+
+    template <bool Simd>
+    std::optional<std::string> decodeVertices(std::span<std::byte> out, size_t count, size_t stride, std::span<const std::byte> in)
+    {
+        if (stride == 0 || stride > vertexBlockMaxSize || stride % 4 != 0)
+        {
+            return "Meshopt vertex stride " + std::to_string(stride) + " is not a multiple of 4 up to 256";
+        }
+        if (!holdsExactly(out.size(), count, stride))
+        {
+            return std::string("Meshopt vertex output has the wrong size");
+        }
+        if (in.size() < 1 + std::max(stride, vertexTailMinSize))
+        {
+            return std::string("Meshopt vertex stream is truncated");
+        }
+
+        Bytes data = reinterpret_cast<Bytes>(in.data());
+        Bytes end = data + in.size();
+        if ((data[0] & 0xF0) != vertexHeader)
+        {
+            return std::string("Not a meshopt vertex stream");
+        }
+        if ((data[0] & 0x0F) > vertexVersion)
+        {
+            return "Unsupported meshopt vertex codec version " + std::to_string(data[0] & 0x0F);
+        }
+        ++data;
+
+        uint8_t last[vertexBlockMaxSize];
+        std::memcpy(last, end - stride, stride);
+
+        auto *target = reinterpret_cast<uint8_t *>(out.data());
+        size_t blockSize = vertexBlockSize(stride);
+        for (size_t offset = 0; offset < count; offset += blockSize)
+        {
+            size_t size = std::min(blockSize, count - offset);
+#if defined(CORE_MESHOPT_SSSE3)
+            if constexpr (Simd)
+            {
+                data = decodeBlockSimd(data, end, target + offset * stride, size, stride, last);
+            }
+            else
+#endif
+            {
+                data = decodeBlockScalar(data, end, target + offset * stride, size, stride, last);
+            }
+            if (!data)
+            {
+                return std::string("Meshopt vertex stream is truncated");
+            }
+        }
+
+        if (size_t(end - data) != std::max(stride, vertexTailMinSize))
+        {
+            return std::string("Meshopt vertex stream has data past its end");
+        }
+        return std::nullopt;
+    }
+
+    uint32_t decodeVByte(Bytes &data) noexcept
+    {
+        uint8_t lead = *data++;
+        if (lead < 128)
+        {
+            return lead;
+        }
+        // At most four more bytes, so malformed data cannot run on
+        uint32_t result = lead & 127;
+        uint32_t shift = 7;
+        for (int i = 0; i < 4; ++i)
+        {
+            uint8_t group = *data++;
+            result |= uint32_t(group & 127) << shift;
+            shift += 7;
+            if (group < 128)
+            {
+                break;
+            }
+        }
+        return result;
+    }
+
+    uint32_t decodeIndex(Bytes &data, uint32_t last) noexcept
+    {
+        uint32_t value = decodeVByte(data);
+        uint32_t delta = (value >> 1) ^ (0u - (value & 1));
+        return last + delta;
+    }
+
+    void writeIndex(std::byte *out, size_t i, size_t indexSize, uint32_t index) noexcept
+    {
+        if (indexSize == 2)
+        {
+            auto narrow = static_cast<uint16_t>(index);
+            std::memcpy(out + i * 2, &narrow, 2);
+        }
+        else
+        {
+            std::memcpy(out + i * 4, &index, 4);
+        }
+    }
+
+    // The FIFOs have 16 entries; every push must happen exactly as in the
+    // encoder or the references that follow point at the wrong entries
+    struct TriangleFifos
+    {
+        uint32_t edges[16][2];
+        uint32_t vertices[16];
+        size_t edgeOffset = 0;
+        size_t vertexOffset = 0;
+
+        TriangleFifos()
+        {
+            std::memset(edges, -1, sizeof(edges));
+            std::memset(vertices, -1, sizeof(vertices));
+        }
+
+        void pushVertex(uint32_t v, bool condition = true) noexcept
+        {
+            vertices[vertexOffset] = v;
+            vertexOffset = (vertexOffset + (condition ? 1 : 0)) & 15;
+        }
+
+        void pushEdge(uint32_t a, uint32_t b) noexcept
+        {
+            edges[edgeOffset][0] = a;
+            edges[edgeOffset][1] = b;
+            edgeOffset = (edgeOffset + 1) & 15;
+        }
+    };
+
+    // Filters, each element read and written through memcpy since the data
+    // comes with no alignment guarantees
+    template <typename T>
+    T loadAt(const std::byte *data) noexcept
+    {
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    void storeAt(std::byte *data, T value) noexcept
+    {
+        std::memcpy(data, &value, sizeof(T));
+    }
+
+    int roundSigned(float value) noexcept
+    {
+        return static_cast<int>(value + (value >= 0.0f ? 0.5f : -0.5f));
+    }
+
+    // x and y carry the octahedral coordinates, z the integer that stands
+    // for 1.0 at the precision the encoder used
+    template <typename T>
+    void octahedralScalar(std::byte *data, size_t begin, size_t end) noexcept
+    {
+        const float max = float((1 << (sizeof(T) * 8 - 1)) - 1);
+        for (size_t i = begin; i < end; ++i)
+        {
+            std::byte *element = data + i * 4 * sizeof(T);
+            float x = float(loadAt<T>(element));
+            float y = float(loadAt<T>(element + sizeof(T)));
+            float z = float(loadAt<T>(element + 2 * sizeof(T))) - std::fabs(x) - std::fabs(y);
+
+            // Fold the lower hemisphere back out
+            float t = z >= 0.0f ? 0.0f : z;
+            x += x >= 0.0f ? t : -t;
+            y += y >= 0.0f ? t : -t;
+
+            float length = std::sqrt(x * x + y * y + z * z);
+            float scale = max / length;
+            storeAt<T>(element, static_cast<T>(roundSigned(x * scale)));
+            storeAt<T>(element + sizeof(T), static_cast<T>(roundSigned(y * scale)));
+            storeAt<T>(element + 2 * sizeof(T), static_cast<T>(roundSigned(z * scale)));
+        }
+    }
+
+    // The low two bits of the fourth component name the dropped one, the
+    // rest give the scale the others were quantized with
+    void quaternionScalar(std::byte *data, size_t begin, size_t end) noexcept
+    {
+        const float scale = 1.0f / std::sqrt(2.0f);
+        for (size_t i = begin; i < end; ++i)
+        {
+            std::byte *element = data + i * 8;
+            int16_t packed = loadAt<int16_t>(element + 6);
+            float s = scale / float(packed | 3);
+            float x = float(loadAt<int16_t>(element)) * s;
+            float y = float(loadAt<int16_t>(element + 2)) * s;
+            float z = float(loadAt<int16_t>(element + 4)) * s;
+            float ww = 1.0f - x * x - y * y - z * z;
+            float w = std::sqrt(ww >= 0.0f ? ww : 0.0f);
+
+            int dropped = packed & 3;
+            storeAt<int16_t>(element + ((dropped + 1) & 3) * 2, static_cast<int16_t>(roundSigned(x * 32767.0f)));
+            storeAt<int16_t>(element + ((dropped + 2) & 3) * 2, static_cast<int16_t>(roundSigned(y * 32767.0f)));
+            storeAt<int16_t>(element + ((dropped + 3) & 3) * 2, static_cast<int16_t>(roundSigned(z * 32767.0f)));
+            storeAt<int16_t>(element + dropped * 2, static_cast<int16_t>(static_cast<int>(w * 32767.0f + 0.5f)));
+        }
+    }
+
+    // Signed 24-bit mantissa times two to the signed 8-bit exponent
+    void exponentialScalar(std::byte *data, size_t begin, size_t end) noexcept
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            uint32_t value = loadAt<uint32_t>(data + i * 4);
+            int32_t mantissa = static_cast<int32_t>(value << 8) >> 8;
+            int32_t exponent = static_cast<int32_t>(value) >> 24;
+            // ldexp by building the power of two directly
+            uint32_t bits = static_cast<uint32_t>(exponent + 127) << 23;
+            float power;
+            std::memcpy(&power, &bits, sizeof(power));
+            storeAt<float>(data + i * 4, power * float(mantissa));
+        }
+    }
+
+#if defined(CORE_MESHOPT_SSE2)
+    // The vector filters do the same float operations in the same order as
+    // the scalar ones, so both give identical results
+    __m128 negativeMask(__m128 value) noexcept
+    {
+        return _mm_and_ps(_mm_cmplt_ps(value, _mm_setzero_ps()), _mm_set1_ps(-0.0f));
+    }
+
+    __m128i roundSigned(__m128 value) noexcept
+    {
+        __m128 half = _mm_or_ps(_mm_set1_ps(0.5f), negativeMask(value));
+        return _mm_cvttps_epi32(_mm_add_ps(value, half));
+    }
+
+    __m128i signExtend(__m128i value, int shift, int width) noexcept
+    {
+        return _mm_srai_epi32(_mm_slli_epi32(value, 32 - shift - width), 32 - width);
+    }
+
+    void octahedral4(__m128i &x, __m128i &y, __m128i &z, float max) noexcept
+    {
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+        __m128 fx = _mm_cvtepi32_ps(x);
+        __m128 fy = _mm_cvtepi32_ps(y);
+        __m128 fz = _mm_sub_ps(_mm_sub_ps(_mm_cvtepi32_ps(z), _mm_and_ps(fx, absMask)), _mm_and_ps(fy, absMask));
+
+        // minps returns its second operand for zeros of either sign, like
+        // the comparison in the scalar filter
+        __m128 t = _mm_min_ps(fz, _mm_setzero_ps());
+        fx = _mm_add_ps(fx, _mm_xor_ps(t, negativeMask(fx)));
+        fy = _mm_add_ps(fy, _mm_xor_ps(t, negativeMask(fy)));
+
+        __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(fx, fx), _mm_mul_ps(fy, fy)), _mm_mul_ps(fz, fz)));
+        __m128 scale = _mm_div_ps(_mm_set1_ps(max), length);
+        x = roundSigned(_mm_mul_ps(fx, scale));
+        y = roundSigned(_mm_mul_ps(fy, scale));
+        z = roundSigned(_mm_mul_ps(fz, scale));
+    }
+
+    // Four elements of four bytes
+    void octahedral8x4(std::byte *data) noexcept
+    {
+        __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+        __m128i x = signExtend(packed, 0, 8);
+        __m128i y = signExtend(packed, 8, 8);
+        __m128i z = signExtend(packed, 16, 8);
+        octahedral4(x, y, z, 127.0f);
+
+        const __m128i byteMask = _mm_set1_epi32(0xFF);
+        __m128i result = _mm_and_si128(packed, _mm_set1_epi32(static_cast<int>(0xFF000000u)));
+        result = _mm_or_si128(result, _mm_and_si128(x, byteMask));
+        result = _mm_or_si128(result, _mm_slli_epi32(_mm_and_si128(y, byteMask), 8));
+        result = _mm_or_si128(result, _mm_slli_epi32(_mm_and_si128(z, byteMask), 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(data), result);
+    }
+
+    // Splits four elements of four 16-bit components into the 32-bit pairs
+    // xy and zw, and joins them back
+    void split16x4(const std::byte *data, __m128i &xy, __m128i &zw) noexcept
+    {
+        __m128 first = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data)));
+        __m128 second = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data + 16)));
+        xy = _mm_castps_si128(_mm_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0)));
+        zw = _mm_castps_si128(_mm_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+
+    void join16x4(std::byte *data, __m128i xy, __m128i zw) noexcept
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(data), _mm_unpacklo_epi32(xy, zw));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(data + 16), _mm_unpackhi_epi32(xy, zw));
+    }
+
+    __m128i pack16(__m128i low, __m128i high) noexcept
+    {
+        return _mm_or_si128(_mm_and_si128(low, _mm_set1_epi32(0xFFFF)), _mm_slli_epi32(high, 16));
+    }
+
+    void octahedral16x4(std::byte *data) noexcept
+    {
+        __m128i xy, zw;
+        split16x4(data, xy, zw);
+        __m128i x = signExtend(xy, 0, 16);
+        __m128i y = signExtend(xy, 16, 16);
+        __m128i z = signExtend(zw, 0, 16);
+        octahedral4(x, y, z, 32767.0f);
+        __m128i w = _mm_srai_epi32(zw, 16);
+        join16x4(data, pack16(x, y), pack16(z, w));
+    }
+
+    // The math runs four wide, but each element's components land in the
+    // order its own dropped index gives, so they are placed one by one
+    void quaternion4(std::byte *data) noexcept
+    {
+        __m128i xy, zw;
+        split16x4(data, xy, zw);
+        __m128i packed = _mm_srai_epi32(zw, 16);
+        __m128 s = _mm_div_ps(_mm_set1_ps(1.0f / std::sqrt(2.0f)), _mm_cvtepi32_ps(_mm_or_si128(packed, _mm_set1_epi32(3))));
+        __m128 x = _mm_mul_ps(_mm_cvtepi32_ps(signExtend(xy, 0, 16)), s);
+        __m128 y = _mm_mul_ps(_mm_cvtepi32_ps(signExtend(xy, 16, 16)), s);
+        __m128 z = _mm_mul_ps(_mm_cvtepi32_ps(signExtend(zw, 0, 16)), s);
+        __m128 ww = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(x, x)), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        __m128 w = _mm_sqrt_ps(_mm_max_ps(ww, _mm_setzero_ps()));
+
+        const __m128 one = _mm_set1_ps(32767.0f);
+        alignas(16) int32_t components[4][4];
+        alignas(16) int32_t dropped[4];
+        _mm_store_si128(reinterpret_cast<__m128i *>(components[0]), roundSigned(_mm_mul_ps(x, one)));
+        _mm_store_si128(reinterpret_cast<__m128i *>(components[1]), roundSigned(_mm_mul_ps(y, one)));
+        _mm_store_si128(reinterpret_cast<__m128i *>(components[2]), roundSigned(_mm_mul_ps(z, one)));
+        _mm_store_si128(reinterpret_cast<__m128i *>(components[3]), _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(w, one), _mm_set1_ps(0.5f))));
+        _mm_store_si128(reinterpret_cast<__m128i *>(dropped), _mm_and_si128(packed, _mm_set1_epi32(3)));
+
+        for (int i = 0; i < 4; ++i)
+        {
+            std::byte *element = data + i * 8;
+            int d = dropped[i];
+            storeAt<int16_t>(element + ((d + 1) & 3) * 2, static_cast<int16_t>(components[0][i]));
+            storeAt<int16_t>(element + ((d + 2) & 3) * 2, static_cast<int16_t>(components[1][i]));
+            storeAt<int16_t>(element + ((d + 3) & 3) * 2, static_cast<int16_t>(components[2][i]));
+            storeAt<int16_t>(element + d * 2, static_cast<int16_t>(components[3][i]));
+        }
+    }
+
+    void exponential4(std::byte *data) noexcept
+    {
+        __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+        __m128i mantissa = _mm_srai_epi32(_mm_slli_epi32(value, 8), 8);
+        __m128i exponent = _mm_srai_epi32(value, 24);
+        __m128 power = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(exponent, _mm_set1_epi32(127)), 23));
+        _mm_storeu_ps(reinterpret_cast<float *>(data), _mm_mul_ps(power, _mm_cvtepi32_ps(mantissa)));
+    }
+#endif
+}
+
+std::optional<std::string> Core::decodeMeshoptVertices(std::span<std::byte> out, size_t count, size_t stride, std::span<const std::byte> in)
+{
+#if defined(CORE_MESHOPT_SSSE3)
+    static const bool hasSsse3 = []
+    {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("ssse3") != 0;
+    }();
+    if (hasSsse3)
+    {
+        return decodeVertices<true>(out, count, stride, in);
+    }
+#endif
+    return decodeVertices<false>(out, count, stride, in);
+}
+
+std::optional<std::string> Core::decodeMeshoptVerticesScalar(std::span<std::byte> out, size_t count, size_t stride, std::span<const std::byte> in)
+{
+    return decodeVertices<false>(out, count, stride, in);
+}
+
+std::optional<std::string> Core::decodeMeshoptTriangles(std::span<std::byte> out, size_t count, size_t indexSize, std::span<const std::byte> in)
+{
+    if (count % 3 != 0 || (indexSize != 2 && indexSize != 4))
+    {
+        return std::string("Meshopt triangles need a multiple of 3 indices of 2 or 4 bytes");
+    }
+    if (!holdsExactly(out.size(), count, indexSize))
+    {
+        return std::string("Meshopt index output has the wrong size");
+    }
+    // Header, a code byte per triangle and the code table at least
+    if (in.size() < 1 + count / 3 + triangleTailSize)
+    {
+        return std::string("Meshopt triangle stream is truncated");
+    }
+
+    Bytes stream = reinterpret_cast<Bytes>(in.data());
+    if ((stream[0] & 0xF0) != triangleHeader)
+    {
+        return std::string("Not a meshopt triangle stream");
+    }
+    int version = stream[0] & 0x0F;
+    if (version > indexVersion)
+    {
+        return "Unsupported meshopt index codec version " + std::to_string(version);
+    }
+
+    TriangleFifos fifos;
+    uint32_t next = 0;
+    uint32_t last = 0;
+    // Version 1 spends two vertex FIFO slots on indices one off the last
+    int fifoLimit = version >= 1 ? 13 : 15;
+
+    Bytes code = stream + 1;
+    Bytes data = code + count / 3;
+    // A triangle reads at most 16 bytes, the size of the table behind the data
+    Bytes dataEnd = stream + in.size() - triangleTailSize;
+    Bytes codeTable = dataEnd;
+
+    for (size_t i = 0; i < count; i += 3)
+    {
+        if (data > dataEnd)
+        {
+            return std::string("Meshopt triangle stream is truncated");
+        }
+
+        uint8_t codeTri = *code++;
+        uint32_t a, b, c;
+        if (codeTri < 0xF0)
+        {
+            // An edge from the FIFO and a third vertex
+            size_t edge = (fifos.edgeOffset - 1 - (codeTri >> 4)) & 15;
+            a = fifos.edges[edge][0];
+            b = fifos.edges[edge][1];
+            int fc = codeTri & 15;
+            if (fc < fifoLimit)
+            {
+                bool isNext = fc == 0;
+                c = isNext ? next++ : fifos.vertices[(fifos.vertexOffset - 1 - fc) & 15];
+                fifos.pushVertex(c, isNext);
+            }
+            else
+            {
+                // 13 and 14 are last - 1 and last + 1, 15 an explicit delta
+                c = last = fc != 15 ? last + uint32_t(fc - (fc ^ 3)) : decodeIndex(data, last);
+                fifos.pushVertex(c);
+            }
+            fifos.pushEdge(c, b);
+            fifos.pushEdge(a, c);
+        }
+        else
+        {
+            int fb, fc;
+            // Vertices from the FIFO are not pushed again
+            bool pushB, pushC;
+            if (codeTri < 0xFE)
+            {
+                // New triangle with its codes in the table
+                uint8_t codeAux = codeTable[codeTri & 15];
+                fb = codeAux >> 4;
+                fc = codeAux & 15;
+                a = next++;
+                b = fb == 0 ? next++ : fifos.vertices[(fifos.vertexOffset - fb) & 15];
+                c = fc == 0 ? next++ : fifos.vertices[(fifos.vertexOffset - fc) & 15];
+                pushB = fb == 0;
+                pushC = fc == 0;
+            }
+            else
+            {
+                // Codes in a byte of their own, where zero restarts the
+                // numbering of new vertices
+                uint8_t codeAux = *data++;
+                bool explicitA = codeTri != 0xFE;
+                fb = codeAux >> 4;
+                fc = codeAux & 15;
+                if (codeAux == 0)
+                {
+                    next = 0;
+                }
+                a = explicitA ? 0 : next++;
+                b = fb == 0 ? next++ : fifos.vertices[(fifos.vertexOffset - fb) & 15];
+                c = fc == 0 ? next++ : fifos.vertices[(fifos.vertexOffset - fc) & 15];
+                if (explicitA)
+                {
+                    a = last = decodeIndex(data, last);
+                }
+                if (fb == 15)
+                {
+                    b = last = decodeIndex(data, last);
+                }
+                if (fc == 15)
+                {
+                    c = last = decodeIndex(data, last);
+                }
+                pushB = fb == 0 || fb == 15;
+                pushC = fc == 0 || fc == 15;
+            }
+            fifos.pushVertex(a);
+            fifos.pushVertex(b, pushB);
+            fifos.pushVertex(c, pushC);
+            fifos.pushEdge(b, a);
+            fifos.pushEdge(c, b);
+            fifos.pushEdge(a, c);
+        }
+
+        writeIndex(out.data(), i, indexSize, a);
+        writeIndex(out.data(), i + 1, indexSize, b);
+        writeIndex(out.data(), i + 2, indexSize, c);
+    }
+
+    if (data != dataEnd)
+    {
+        return std::string("Meshopt triangle stream has data past its end");
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> Core::decodeMeshoptIndices(std::span<std::byte> out, size_t count, size_t indexSize, std::span<const std::byte> in)
+{
+    if (indexSize != 2 && indexSize != 4)
+    {
+        return std::string("Meshopt indices must be 2 or 4 bytes");
+    }
+    if (!holdsExactly(out.size(), count, indexSize))
+    {
+        return std::string("Meshopt index output has the wrong size");
+    }
+    // Header, at least a byte per index and the tail
+    if (in.size() < 1 + count + sequenceTailSize)
+    {
+        return std::string("Meshopt index stream is truncated");
+    }
+
+    Bytes stream = reinterpret_cast<Bytes>(in.data());
+    if ((stream[0] & 0xF0) != sequenceHeader)
+    {
+        return std::string("Not a meshopt index stream");
+    }
+    int version = stream[0] & 0x0F;
+    if (version > indexVersion)
+    {
+        return "Unsupported meshopt index codec version " + std::to_string(version);
+    }
+
+    Bytes data = stream + 1;
+    // An index reads at most 5 bytes, the tail covers what overhangs
+    Bytes dataEnd = stream + in.size() - sequenceTailSize;
+    // Deltas are against one of two baselines, picked by the low bit
+    uint32_t last[2] = {};
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (data >= dataEnd)
+        {
+            return std::string("Meshopt index stream is truncated");
+        }
+        uint32_t value = decodeVByte(data);
+        uint32_t baseline = value & 1;
+        value >>= 1;
+        uint32_t index = last[baseline] + ((value >> 1) ^ (0u - (value & 1)));
+        last[baseline] = index;
+        writeIndex(out.data(), i, indexSize, index);
+    }
+
+    if (data != dataEnd)
+    {
+        return std::string("Meshopt index stream has data past its end");
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> Core::applyMeshoptFilter(MeshoptFilter filter, std::span<std::byte> data, size_t count, size_t stride)
+{
+    if (!holdsExactly(data.size(), count, stride))
+    {
+        return std::string("Meshopt filter data has the wrong size");
+    }
+
+    std::byte *bytes = data.data();
+    size_t vectorEnd = 0;
+    switch (filter)
+    {
+    case MeshoptFilter::None:
+        return std::nullopt;
+    case MeshoptFilter::Octahedral:
+        if (stride != 4 && stride != 8)
+        {
+            return std::string("Octahedral filter needs a stride of 4 or 8");
+        }
+#if defined(CORE_MESHOPT_SSE2)
+        for (vectorEnd = 0; vectorEnd + 4 <= count; vectorEnd += 4)
+        {
+            stride == 4 ? octahedral8x4(bytes + vectorEnd * 4) : octahedral16x4(bytes + vectorEnd * 8);
+        }
+#endif
+        stride == 4 ? octahedralScalar<int8_t>(bytes, vectorEnd, count) : octahedralScalar<int16_t>(bytes, vectorEnd, count);
+        return std::nullopt;
+    case MeshoptFilter::Quaternion:
+        if (stride != 8)
+        {
+            return std::string("Quaternion filter needs a stride of 8");
+        }
+#if defined(CORE_MESHOPT_SSE2)
+        for (vectorEnd = 0; vectorEnd + 4 <= count; vectorEnd += 4)
+        {
+            quaternion4(bytes + vectorEnd * 8);
+        }
+#endif
+        quaternionScalar(bytes, vectorEnd, count);
+        return std::nullopt;
+    case MeshoptFilter::Exponential:
+    {
+        if (stride % 4 != 0)
+        {
+            return std::string("Exponential filter needs a stride that is a multiple of 4");
+        }
+        // Every 32-bit value is independent of the element it sits in
+        size_t values = count * stride / 4;
+#if defined(CORE_MESHOPT_SSE2)
+        for (vectorEnd = 0; vectorEnd + 4 <= values; vectorEnd += 4)
+        {
+            exponential4(bytes + vectorEnd * 4);
+        }
+#endif
+        exponentialScalar(bytes, vectorEnd, values);
+        return std::nullopt;
+    }
+    }
+    return std::string("Unknown meshopt filter");
+}
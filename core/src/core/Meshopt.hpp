@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string>
+
+namespace Core
+{
+    // Decoders for the meshoptimizer codecs that EXT_meshopt_compression
+    // stores buffer views with. All of them write exactly count * stride
+    // bytes to out and fail on streams that are malformed or do not decode
+    // to that size, without reading past the input or writing past out.
+
+    // Post-decode transforms that undo the quantization the encoder applied
+    // to vertex data, in place
+    enum class MeshoptFilter
+    {
+        None,
+        // Unit vectors as octahedral x/y in 8 or 16-bit signed integers,
+        // expanded to normalized xyz, w untouched
+        Octahedral,
+        // Unit quaternions as three 16-bit components with the largest one
+        // dropped, restored to four normalized components
+        Quaternion,
+        // Floats as a 24-bit mantissa with an 8-bit exponent
+        Exponential
+    };
+
+    // Vertex attribute codec (header 0xA0): vertices are split into blocks,
+    // and each byte of the vertex is delta coded against the previous vertex
+    // and bit packed in groups of 16. stride is a multiple of 4, up to 256.
+    // Uses pshufb to expand the packed groups on x86 CPUs with SSSE3.
+    [[nodiscard]] std::optional<std::string> decodeMeshoptVertices(std::span<std::byte> out, size_t count, size_t stride, std::span<const std::byte> in);
+
+    // The byte-at-a-time path alone, as a reference for decodeMeshoptVertices
+    [[nodiscard]] std::optional<std::string> decodeMeshoptVerticesScalar(std::span<std::byte> out, size_t count, size_t stride, std::span<const std::byte> in);
+
+    // Triangle list codec (header 0xE0), with indices of 2 or 4 bytes.
+    // Triangles are coded against FIFOs of recent edges and vertices.
+    [[nodiscard]] std::optional<std::string> decodeMeshoptTriangles(std::span<std::byte> out, size_t count, size_t indexSize, std::span<const std::byte> in);
+
+    // Index sequence codec (header 0xD0) for anything that is not a
+    // triangle list, with indices of 2 or 4 bytes
+    [[nodiscard]] std::optional<std::string> decodeMeshoptIndices(std::span<std::byte> out, size_t count, size_t indexSize, std::span<const std::byte> in);
+
+    // Applies filter to count elements of stride bytes. Runs four elements
+    // per step with SSE2.
+    [[nodiscard]] std::optional<std::string> applyMeshoptFilter(MeshoptFilter filter, std::span<std::byte> data, size_t count, size_t stride);
+}
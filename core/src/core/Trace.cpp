@@ -0,0 +1,207 @@
+#include "Trace.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const Clock::time_point epoch = Clock::now();
+
+    struct Event
+    {
+        const char *name;
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    constexpr size_t chunkSize = 1024;
+
+    // Written only by the owning thread, count is published after each event
+    struct Chunk
+    {
+        std::array<Event, chunkSize> events;
+        std::atomic<size_t> count{0};
+        std::atomic<Chunk *> next{nullptr};
+    };
+
+    struct Track
+    {
+        uint32_t id;
+        std::atomic<const char *> name{nullptr};
+        Chunk head;
+        Chunk *tail = &head;
+        std::atomic<Track *> next{nullptr};
+    };
+
+    // Tracks are never freed: events must survive their threads until the
+    // trace is written, possibly at exit
+    std::atomic<Track *> tracks{nullptr};
+    std::atomic<uint32_t> nextTrackId{1};
+    std::atomic<bool> enabled{false};
+
+    std::string exitPath;
+    std::once_flag exitRegistered;
+
+    Track *createTrack(const char *name)
+    {
+        auto *track = new Track;
+        track->id = nextTrackId.fetch_add(1, std::memory_order_relaxed);
+        track->name.store(name, std::memory_order_relaxed);
+
+        Track *head = tracks.load(std::memory_order_relaxed);
+        do
+        {
+            track->next.store(head, std::memory_order_relaxed);
+        } while (!tracks.compare_exchange_weak(head, track, std::memory_order_release, std::memory_order_relaxed));
+        return track;
+    }
+
+    Track &threadTrack()
+    {
+        thread_local Track *track = createTrack(nullptr);
+        return *track;
+    }
+
+    void append(Track &track, const Event &event)
+    {
+        Chunk *chunk = track.tail;
+        size_t count = chunk->count.load(std::memory_order_relaxed);
+        if (count == chunkSize)
+        {
+            auto *fresh = new Chunk;
+            chunk->next.store(fresh, std::memory_order_release);
+            track.tail = fresh;
+            chunk = fresh;
+            count = 0;
+        }
+        chunk->events[count] = event;
+        chunk->count.store(count + 1, std::memory_order_release);
+    }
+
+    void writeQuoted(std::ostream &out, const char *text)
+    {
+        out << '"';
+        for (; *text; ++text)
+        {
+            if (*text == '"' || *text == '\\')
+            {
+                out << '\\';
+            }
+            out << *text;
+        }
+        out << '"';
+    }
+
+    void writeAtExit()
+    {
+        if (auto error = Core::Trace::write(exitPath); error)
+        {
+            std::cerr << "Trace Error: " << *error << '\n';
+        }
+    }
+}
+
+uint64_t Core::Trace::now() noexcept
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch).count());
+}
+
+void Core::Trace::enable(const std::string &path)
+{
+    if (!path.empty())
+    {
+        exitPath = path;
+        std::call_once(exitRegistered, []
+                       { std::atexit(writeAtExit); });
+    }
+    enabled.store(true, std::memory_order_relaxed);
+}
+
+void Core::Trace::disable() noexcept
+{
+    enabled.store(false, std::memory_order_relaxed);
+}
+
+bool Core::Trace::isEnabled() noexcept
+{
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void Core::Trace::setThreadName(const char *name)
+{
+    threadTrack().name.store(name, std::memory_order_relaxed);
+}
+
+void Core::Trace::record(const char *name, uint64_t begin, uint64_t end)
+{
+    append(threadTrack(), {name, begin, end});
+}
+
+void Core::Trace::recordOnTrack(const char *track, const char *name, uint64_t begin, uint64_t end)
+{
+    // Named tracks are looked up by pointer, callers pass literals
+    thread_local std::vector<std::pair<const char *, Track *>> namedTracks;
+    for (auto &[trackName, named] : namedTracks)
+    {
+        if (trackName == track)
+        {
+            append(*named, {name, begin, end});
+            return;
+        }
+    }
+    Track *named = createTrack(track);
+    namedTracks.emplace_back(track, named);
+    append(*named, {name, begin, end});
+}
+
+std::optional<std::string> Core::Trace::write(const std::string &path)
+{
+    std::ofstream out(path);
+    if (!out)
+    {
+        return "Failed to open " + path;
+    }
+
+    out << "{\"traceEvents\": [\n";
+    out << std::fixed << std::setprecision(3);
+    bool first = true;
+    for (Track *track = tracks.load(std::memory_order_acquire); track; track = track->next.load(std::memory_order_relaxed))
+    {
+        const char *name = track->name.load(std::memory_order_relaxed);
+        out << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << track->id << ", \"args\": {\"name\": ";
+        writeQuoted(out, name ? name : ("Thread " + std::to_string(track->id)).c_str());
+        out << "}}";
+        first = false;
+
+        for (Chunk *chunk = &track->head; chunk; chunk = chunk->next.load(std::memory_order_acquire))
+        {
+            size_t count = chunk->count.load(std::memory_order_acquire);
+            for (size_t i = 0; i < count; ++i)
+            {
+                const Event &event = chunk->events[i];
+                out << ",\n{\"name\": ";
+                writeQuoted(out, event.name);
+                out << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << track->id
+                    << ", \"ts\": " << event.begin / 1000.0
+                    << ", \"dur\": " << (event.end - event.begin) / 1000.0 << "}";
+            }
+        }
+    }
+    out << "\n], \"displayTimeUnit\": \"ms\"}\n";
+
+    if (!out)
+    {
+        return "Failed to write " + path;
+    }
+    return std::nullopt;
+}
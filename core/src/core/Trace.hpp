@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+// Trace zones cost nothing unless core is built with CORE_PROFILER
+#ifdef CORE_PROFILER
+#define CORE_TRACE_CONCAT_INNER(a, b) a##b
+#define CORE_TRACE_CONCAT(a, b) CORE_TRACE_CONCAT_INNER(a, b)
+#define CORE_TRACE_ZONE(name) ::Core::Trace::Scope CORE_TRACE_CONCAT(coreTraceZone, __LINE__)(name)
+#else
+#define CORE_TRACE_ZONE(name) ((void)0)
+#endif
+
+namespace Core::Trace
+{
+    // Timeline of scoped zones from every thread, written as Chrome trace
+    // event JSON (chrome://tracing, ui.perfetto.dev). Each thread appends to
+    // its own chunked buffer and publishes events with a release store, so
+    // recording takes no locks; buffers outlive their threads so nothing is
+    // lost before the trace is written. Names must be string literals or
+    // otherwise live until the trace is written.
+
+    // Nanoseconds on the trace clock
+    [[nodiscard]] uint64_t now() noexcept;
+
+    // Recording is off until enabled. With a path, the trace is also
+    // written there when the process exits.
+    void enable(const std::string &exitPath = "");
+    void disable() noexcept;
+    [[nodiscard]] bool isEnabled() noexcept;
+
+    // Labels the calling thread's track
+    void setThreadName(const char *name);
+
+    // Adds a finished zone to the calling thread's track
+    void record(const char *name, uint64_t begin, uint64_t end);
+
+    // Adds a finished zone to a named track of its own, such as GPU time
+    // converted to the trace clock. Only one thread may feed a given track.
+    void recordOnTrack(const char *track, const char *name, uint64_t begin, uint64_t end);
+
+    // Writes everything recorded so far, safe while other threads record
+    std::optional<std::string> write(const std::string &path);
+
+    class Scope
+    {
+    private:
+        const char *name;
+        uint64_t begin;
+
+    public:
+        explicit Scope(const char *zoneName)
+            : name(isEnabled() ? zoneName : nullptr),
+              begin(name ? now() : 0)
+        {
+        }
+
+        ~Scope()
+        {
+            if (name)
+            {
+                record(name, begin, now());
+            }
+        }
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    };
+}
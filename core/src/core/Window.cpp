@@ -1,10 +1,24 @@
 #include "Window.hpp"
+#include "GL/Extensions.hpp"
+#include <cstring>
 #include <iostream>
 
-Core::Window::Window(int width, int height, const char *name)
+#ifdef CORE_HAS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+Core::Window::Window(int width, int height, const char *name, WindowBackend backend)
 {
   _width = width;
   _height = height;
+  _backend = backend;
+
+  if (backend == WindowBackend::Headless)
+  {
+    _open = createHeadless();
+    return;
+  }
 
   if (!glfwInit())
   {
@@ -33,28 +47,184 @@ Core::Window::Window(int width, int height, const char *name)
     std::cerr << "Failed to initialize GLAD" << std::endl;
     return;
   }
+  GL::loadExtensions((GL::ProcLoader)glfwGetProcAddress);
 
   std::cout << "OpenGL " << glGetString(GL_VERSION) << std::endl;
   glViewport(0, 0, width, height);
+  _open = true;
 }
 
 Core::Window::~Window()
 {
-  glfwDestroyWindow(window);
-  glfwTerminate();
+  if (_backend == WindowBackend::Headless)
+  {
+    destroyHeadless();
+    return;
+  }
+
+  if (window)
+  {
+    glfwDestroyWindow(window);
+    glfwTerminate();
+  }
 }
 
 void Core::Window::swapBuffers()
 {
+  if (_backend == WindowBackend::Headless)
+  {
+    // Nothing to present, just make sure the frame is submitted
+    glFlush();
+    return;
+  }
+
   glfwSwapBuffers(window);
 }
 
 void Core::Window::pollEvents()
 {
-  glfwPollEvents();
+  if (_backend == WindowBackend::GLFW)
+  {
+    glfwPollEvents();
+  }
 }
 
 bool Core::Window::shouldClose() const
 {
-  return glfwWindowShouldClose(window);
+  if (_closeRequested || !_open)
+  {
+    return true;
+  }
+  return _backend == WindowBackend::GLFW && glfwWindowShouldClose(window);
+}
+
+void Core::Window::close()
+{
+  _closeRequested = true;
+}
+
+std::vector<unsigned char> Core::Window::readPixels() const
+{
+  std::vector<unsigned char> pixels(static_cast<size_t>(_width) * _height * 4);
+  if (!_open)
+  {
+    return pixels;
+  }
+
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, _width, _height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+  return pixels;
+}
+
+bool Core::Window::createHeadless()
+{
+#ifdef CORE_HAS_EGL
+  auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+  EGLDisplay display = getPlatformDisplay ? getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr) : EGL_NO_DISPLAY;
+  if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr))
+  {
+    std::cerr << "Failed to initialize EGL surfaceless display" << std::endl;
+    return false;
+  }
+  _eglDisplay = display;
+
+  if (!eglBindAPI(EGL_OPENGL_API))
+  {
+    std::cerr << "EGL does not support desktop OpenGL" << std::endl;
+    return false;
+  }
+
+  // Surfaceless contexts need no config, but fall back to any OpenGL
+  // config for drivers without EGL_KHR_no_config_context
+  const char *extensions = eglQueryString(display, EGL_EXTENSIONS);
+  EGLConfig config = EGL_NO_CONFIG_KHR;
+  if (!extensions || !std::strstr(extensions, "EGL_KHR_no_config_context"))
+  {
+    const EGLint configAttributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+    EGLint configCount = 0;
+    if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0)
+    {
+      std::cerr << "No EGL config supports OpenGL" << std::endl;
+      return false;
+    }
+  }
+
+  // Prefer 4.6 like the GLFW path, software rasterizers may stop at 4.5
+  EGLContext context = EGL_NO_CONTEXT;
+  for (EGLint minor : {6, 5})
+  {
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 4,
+        EGL_CONTEXT_MINOR_VERSION, minor,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE};
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+    if (context != EGL_NO_CONTEXT)
+    {
+      break;
+    }
+  }
+  if (context == EGL_NO_CONTEXT)
+  {
+    std::cerr << "Failed to create an OpenGL 4.5 core context with EGL" << std::endl;
+    return false;
+  }
+  _eglContext = context;
+
+  if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+  {
+    std::cerr << "Failed to make the surfaceless context current" << std::endl;
+    return false;
+  }
+
+  if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+  {
+    std::cerr << "Failed to initialize GLAD" << std::endl;
+    return false;
+  }
+  GL::loadExtensions((GL::ProcLoader)eglGetProcAddress);
+  std::cout << "OpenGL " << glGetString(GL_VERSION) << " (headless)" << std::endl;
+
+  // There is no default framebuffer, this one stays bound in its place
+  glCreateRenderbuffers(1, &_colorBuffer);
+  glNamedRenderbufferStorage(_colorBuffer, GL_RGBA8, _width, _height);
+  glCreateRenderbuffers(1, &_depthBuffer);
+  glNamedRenderbufferStorage(_depthBuffer, GL_DEPTH24_STENCIL8, _width, _height);
+  glCreateFramebuffers(1, &_framebuffer);
+  glNamedFramebufferRenderbuffer(_framebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, _colorBuffer);
+  glNamedFramebufferRenderbuffer(_framebuffer, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, _depthBuffer);
+  if (glCheckNamedFramebufferStatus(_framebuffer, GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+  {
+    std::cerr << "Headless framebuffer is incomplete" << std::endl;
+    return false;
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, _framebuffer);
+  glViewport(0, 0, _width, _height);
+  return true;
+#else
+  std::cerr << "Headless window backend not available, configure with CORE_HEADLESS=ON" << std::endl;
+  return false;
+#endif
+}
+
+void Core::Window::destroyHeadless()
+{
+#ifdef CORE_HAS_EGL
+  // GL names are only created once GLAD is loaded
+  if (_colorBuffer)
+  {
+    glDeleteFramebuffers(1, &_framebuffer);
+    glDeleteRenderbuffers(1, &_colorBuffer);
+    glDeleteRenderbuffers(1, &_depthBuffer);
+  }
+  if (_eglDisplay)
+  {
+    eglMakeCurrent(_eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (_eglContext)
+    {
+      eglDestroyContext(_eglDisplay, _eglContext);
+    }
+    eglTerminate(_eglDisplay);
+  }
+#endif
 }
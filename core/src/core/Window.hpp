@@ -2,21 +2,56 @@
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <vector>
 
 namespace Core
 {
+  enum class WindowBackend
+  {
+    // On-screen window through GLFW
+    GLFW,
+    // Offscreen EGL context on Mesa's surfaceless platform, rendering into
+    // a framebuffer object. Needs neither a display server nor a GPU, Mesa
+    // falls back to llvmpipe.
+    Headless
+  };
+
   class Window
   {
   public:
-    Window(int width, int height, const char *name);
+    Window(int width, int height, const char *name, WindowBackend backend = WindowBackend::GLFW);
     ~Window();
 
     void swapBuffers();
     void pollEvents();
     bool shouldClose() const;
+    void close();
+
+    // False when no context could be created
+    bool isOpen() const { return _open; }
+    int getWidth() const { return _width; }
+    int getHeight() const { return _height; }
+    WindowBackend getBackend() const { return _backend; }
+
+    // RGBA8 copy of the color buffer, bottom row first
+    std::vector<unsigned char> readPixels() const;
 
   private:
+    bool createHeadless();
+    void destroyHeadless();
+
     int _width, _height;
-    GLFWwindow *window;
+    WindowBackend _backend;
+    bool _open = false;
+    bool _closeRequested = false;
+    GLFWwindow *window = nullptr;
+
+    // Headless only, EGL handles are kept opaque so users of this header
+    // do not need the EGL headers
+    void *_eglDisplay = nullptr;
+    void *_eglContext = nullptr;
+    GLuint _framebuffer = 0;
+    GLuint _colorBuffer = 0;
+    GLuint _depthBuffer = 0;
   };
 }
@@ -1,10 +1,23 @@
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+#include <core/Trace.hpp>
 #include <core/Window.hpp>
 #include <core/GL/GLBuffer.hpp>
 #include <core/GL/VAO.hpp>
 #include <core/GL/GLShader.hpp>
+#include <core/GL/Profiler.hpp>
+#include <core/GL/RenderQueue.hpp>
+#include <core/GL/ShaderReloader.hpp>
+#include <core/GL/TextureLoader.hpp>
+#include <core/GLTF/Document.hpp>
+#include <core/GLTF/Model.hpp>
+#include <core/GLTF/SceneCache.hpp>
+#include <core/GLTF/StaticBatch.hpp>
 
-int main()
+int main(int argc, char **argv)
 {
   std::vector<float> positions = {
       -1.0f, -1.0f, 0.0f,
@@ -23,7 +36,57 @@ int main()
   };
   std::vector<unsigned int> indices = {0, 3, 2, 0, 2, 1};
 
-  Core::Window window(800, 600, "Triangle");
+  // Optional .glb/.gltf to draw instead of the quad, --indirect packs it
+  // into a static batch drawn with multi-draw indirect, cooked to
+  // .scene-cache on first load and mapped from there afterwards. --headless
+  // renders offscreen for --frames frames and can save the last one.
+  // --trace writes a Chrome trace of the run at exit.
+  std::string modelPath;
+  std::string screenshotPath;
+  std::string tracePath;
+  bool indirect = false;
+  bool headless = false;
+  int frames = 1;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string_view argument = argv[i];
+    if (argument == "--indirect")
+    {
+      indirect = true;
+    }
+    else if (argument == "--headless")
+    {
+      headless = true;
+    }
+    else if (argument == "--frames" && i + 1 < argc)
+    {
+      frames = std::max(1, std::atoi(argv[++i]));
+    }
+    else if (argument == "--screenshot" && i + 1 < argc)
+    {
+      screenshotPath = argv[++i];
+    }
+    else if (argument == "--trace" && i + 1 < argc)
+    {
+      tracePath = argv[++i];
+    }
+    else
+    {
+      modelPath = argv[i];
+    }
+  }
+
+  if (!tracePath.empty())
+  {
+    Core::Trace::setThreadName("Main");
+    Core::Trace::enable(tracePath);
+  }
+
+  Core::Window window(800, 600, "Triangle", headless ? Core::WindowBackend::Headless : Core::WindowBackend::GLFW);
+  if (!window.isOpen())
+  {
+    return -1;
+  }
 
   Core::GL::GLBuffer vboPos(Core::GL::BufferType::Vertex);
   Core::GL::GLBuffer vboUvs(Core::GL::BufferType::Vertex);
@@ -52,27 +115,176 @@ int main()
   vao.addVertexBuffer(vboUvs, 1, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 2, 0);
   vao.setIndexBuffer(ebo);
 
-  Core::GL::GLShader shader("assets/shaders/basic/vertex.glsl", "assets/shaders/basic/fragment.glsl");
+  std::optional<Core::GLTF::Model> model;
+  std::optional<Core::GLTF::StaticBatch> batch;
+  Core::GLTF::SceneCache sceneCache(".scene-cache");
+  Core::GLTF::StaticBatch::Geometry cookedGeometry;
+  if (auto cooked = indirect && !modelPath.empty() ? sceneCache.load(modelPath, cookedGeometry) : std::nullopt; cooked)
+  {
+    if (auto error = batch.emplace().build(cookedGeometry); error)
+    {
+      std::cerr << "glTF Upload Error: " << *error << std::endl;
+      return -1;
+    }
+  }
+  else if (!modelPath.empty())
+  {
+    Core::GLTF::Document document;
+    if (auto error = document.loadFromFile(modelPath); error)
+    {
+      std::cerr << "glTF Error: " << *error << std::endl;
+      return -1;
+    }
+
+    std::optional<std::string> error;
+    if (indirect)
+    {
+      Core::GLTF::StaticBatch::DecodedGeometry geometry;
+      error = Core::GLTF::StaticBatch::decode(document, geometry);
+      error = error ? error : batch.emplace().build(geometry.view());
+      if (!error)
+      {
+        std::cout << "Vertex cache ACMR " << geometry.cacheBefore.getACMR() << " -> " << geometry.cacheAfter.getACMR()
+                  << ", ATVR " << geometry.cacheBefore.getATVR() << " -> " << geometry.cacheAfter.getATVR() << std::endl;
+        if (auto cookError = sceneCache.store(modelPath, document, geometry.view()); cookError)
+        {
+          std::cerr << "Scene cache: " << *cookError << std::endl;
+        }
+      }
+    }
+    else
+    {
+      error = model.emplace().upload(document);
+      if (!error)
+      {
+        std::cout << "Vertex cache ACMR " << model->getCacheBefore().getACMR() << " -> " << model->getCacheAfter().getACMR()
+                  << ", ATVR " << model->getCacheBefore().getATVR() << " -> " << model->getCacheAfter().getATVR() << std::endl;
+      }
+    }
+    if (error)
+    {
+      std::cerr << "glTF Upload Error: " << *error << std::endl;
+      return -1;
+    }
+  }
+
+  Core::GL::ShaderCache shaderCache(".shader-cache");
+  std::optional<Core::GL::GLShader> indirectShader;
+  if (batch)
+  {
+    indirectShader.emplace("assets/shaders/indirect/vertex.glsl", "assets/shaders/indirect/fragment.glsl", &shaderCache, Core::GL::CompileMode::Deferred);
+  }
+
+  // Only the feature combinations the scene uses are compiled, side by side
+  Core::GL::ShaderVariants variants("assets/shaders/basic/vertex.glsl", "assets/shaders/basic/fragment.glsl", Core::GLTF::shaderFeatureDefines(), &shaderCache);
+  std::vector<Core::GL::ShaderVariants::Features> features = {0};
+  if (model)
+  {
+    auto used = model->getShaderFeatures();
+    features.insert(features.end(), used.begin(), used.end());
+  }
+  variants.prepare(features);
+  Core::GL::GLShader &shader = variants.get(0);
+  Core::GL::UniformHandle indirectTexture;
+  if (indirectShader)
+  {
+    indirectShader->finish();
+    indirectTexture = indirectShader->getHandle("u_texture");
+  }
+
+  // The render queue writes each transform at the start of the Object block
+  const auto *objectBlock = shader.findBlock("ObjectData");
+  const auto *modelMember = objectBlock ? objectBlock->findMember("u_model") : nullptr;
+  if (!modelMember || modelMember->offset != 0 || objectBlock->binding != static_cast<GLint>(Core::GL::UniformBinding::Object))
+  {
+    std::cerr << "Warning: ObjectData block does not match the render queue layout" << std::endl;
+  }
 
   glEnable(GL_DEBUG_OUTPUT);
   glDebugMessageCallback([](GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *message, const void *userParam)
                          { std::cerr << "OpenGL Debug Message: " << message << std::endl; }, nullptr);
 
-  Core::GL::GLTexture texture;
-  texture.loadFromFile("assets/textures/tree.jpg");
+  Core::GL::TextureLoader textureLoader(16 * 1024 * 1024, Core::JobSystem::shared(), ".texture-cache");
+  auto texture = textureLoader.loadAsync("assets/textures/tree.jpg");
+
+  Core::GL::RenderQueue renderQueue;
+
+  // Edited shader files are rebuilt and swapped in while the viewer runs
+  Core::GL::ShaderReloader shaderReloader;
+  shaderReloader.watch(variants);
+  if (indirectShader)
+  {
+    shaderReloader.watch(*indirectShader);
+  }
+
+#ifdef CORE_PROFILER
+  Core::GL::Profiler profiler;
+#endif
 
+  int frame = 0;
   while (!window.shouldClose())
   {
-    window.pollEvents();
+    CORE_PROFILE_BEGIN_FRAME();
+    {
+      CORE_PROFILE_ZONE("Frame");
+      window.pollEvents();
+      textureLoader.update();
+      shaderReloader.update();
+
+      glClearColor(0.82, 0.0, 0.07, 1.0);
+      glClear(GL_COLOR_BUFFER_BIT);
+
+      if (batch)
+      {
+        indirectShader->use();
+        indirectShader->setTexture(indirectTexture, *texture, 0);
+        batch->draw();
+      }
+      else
+      {
+        CORE_PROFILE_ZONE("Scene");
+        Core::GL::DrawPacket packet;
+        packet.program = shader.getID();
+        packet.texture = texture->getId();
+        packet.objectBlock = true;
+        if (model)
+        {
+          model->enqueue(renderQueue, packet, variants);
+        }
+        else
+        {
+          packet.vertexArray = vao.getID();
+          packet.count = 6;
+          packet.indexType = GL_UNSIGNED_INT;
+          renderQueue.push(packet);
+        }
+        renderQueue.flush();
+      }
+    }
+    CORE_PROFILE_END_FRAME();
 
-    glClearColor(0.82, 0.0, 0.07, 1.0);
-    glClear(GL_COLOR_BUFFER_BIT);
+    ++frame;
+#ifdef CORE_PROFILER
+    // Results lag a few frames behind, print about once a second
+    if (frame % 60 == 0 || (headless && frame == frames))
+    {
+      profiler.printSummary(std::cout);
+    }
+#endif
 
-    vao.bind();
-    shader.use();
-    shader.setTexture("u_texture", texture, 0);
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr);
-    vao.unbind();
+    if (headless && frame == frames)
+    {
+      if (!screenshotPath.empty())
+      {
+        auto pixels = window.readPixels();
+        stbi_flip_vertically_on_write(true);
+        if (!stbi_write_png(screenshotPath.c_str(), window.getWidth(), window.getHeight(), 4, pixels.data(), window.getWidth() * 4))
+        {
+          std::cerr << "Failed to write screenshot: " << screenshotPath << std::endl;
+        }
+      }
+      window.close();
+    }
 
     window.swapBuffers();
   }
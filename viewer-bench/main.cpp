@@ -0,0 +1,521 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <core/Base64.hpp>
+#include <core/Window.hpp>
+#include <core/GL/GLShader.hpp>
+#include <core/GL/GLState.hpp>
+#include <core/GL/GLTexture.hpp>
+#include <core/GL/RenderQueue.hpp>
+#include <core/GLTF/Document.hpp>
+#include <core/GLTF/Model.hpp>
+#include <core/GLTF/StaticBatch.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Renders a glTF scene offscreen and reports frame times and GL counters as
+// JSON, for tracking core performance on machines without a display
+
+namespace
+{
+  using Clock = std::chrono::steady_clock;
+
+  struct Options
+  {
+    std::string scenePath;
+    std::string texturePath;
+    std::string outputPath;
+    int frames = 300;
+    int warmup = 10;
+    int width = 1280;
+    int height = 720;
+    bool indirect = false;
+    bool uniforms = false;
+    bool base64 = false;
+    bool base64Fuzz = false;
+  };
+
+  double milliseconds(Clock::duration duration)
+  {
+    return std::chrono::duration<double, std::milli>(duration).count();
+  }
+
+  size_t peakResidentBytes()
+  {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+    return counters.PeakWorkingSetSize;
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+  }
+
+  // Nearest-rank percentile of sorted samples
+  double percentile(const std::vector<double> &sorted, double p)
+  {
+    if (sorted.empty())
+    {
+      return 0.0;
+    }
+    size_t rank = static_cast<size_t>(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+  }
+
+  std::string quoted(std::string_view text)
+  {
+    std::string result = "\"";
+    for (char c : text)
+    {
+      if (c == '"' || c == '\\')
+      {
+        result += '\\';
+      }
+      result += c;
+    }
+    return result + "\"";
+  }
+
+  void writeTimings(std::ostream &out, std::vector<double> samples)
+  {
+    std::sort(samples.begin(), samples.end());
+    double total = 0.0;
+    for (double sample : samples)
+    {
+      total += sample;
+    }
+    out << "{\"mean\": " << (samples.empty() ? 0.0 : total / samples.size())
+        << ", \"p50\": " << percentile(samples, 50)
+        << ", \"p90\": " << percentile(samples, 90)
+        << ", \"p99\": " << percentile(samples, 99)
+        << ", \"max\": " << (samples.empty() ? 0.0 : samples.back()) << "}";
+  }
+
+  void writeCounters(std::ostream &out, const char *name, const Core::GL::GLState::Counters &counters)
+  {
+    out << "\"" << name << "\": {\"issued\": " << counters.issued << ", \"elided\": " << counters.elided << "}";
+  }
+
+  std::optional<Options> parseOptions(int argc, char **argv)
+  {
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+      std::string_view argument = argv[i];
+      bool hasValue = i + 1 < argc;
+      if (argument == "--indirect")
+      {
+        options.indirect = true;
+      }
+      else if (argument == "--uniforms")
+      {
+        options.uniforms = true;
+      }
+      else if (argument == "--base64")
+      {
+        options.base64 = true;
+      }
+      else if (argument == "--base64-fuzz")
+      {
+        options.base64Fuzz = true;
+      }
+      else if (argument == "--frames" && hasValue)
+      {
+        options.frames = std::max(1, std::atoi(argv[++i]));
+      }
+      else if (argument == "--warmup" && hasValue)
+      {
+        options.warmup = std::max(0, std::atoi(argv[++i]));
+      }
+      else if (argument == "--width" && hasValue)
+      {
+        options.width = std::max(1, std::atoi(argv[++i]));
+      }
+      else if (argument == "--height" && hasValue)
+      {
+        options.height = std::max(1, std::atoi(argv[++i]));
+      }
+      else if (argument == "--texture" && hasValue)
+      {
+        options.texturePath = argv[++i];
+      }
+      else if (argument == "--output" && hasValue)
+      {
+        options.outputPath = argv[++i];
+      }
+      else if (!argument.starts_with("--") && options.scenePath.empty())
+      {
+        options.scenePath = argv[i];
+      }
+      else
+      {
+        return std::nullopt;
+      }
+    }
+    if (options.scenePath.empty() && !options.base64Fuzz)
+    {
+      return std::nullopt;
+    }
+    return options;
+  }
+
+  // Time to fill a texture with each mipmap mode, GPU work included. The
+  // first round only warms up the driver's mipmap generation.
+  std::pair<double, double> measureMipmaps(const std::string &path)
+  {
+    double results[2] = {};
+    Core::GL::MipmapMode modes[2] = {Core::GL::MipmapMode::Driver, Core::GL::MipmapMode::CPU};
+    for (int i = 0; i < 4; ++i)
+    {
+      Core::GL::GLTexture texture;
+      glFinish();
+      auto start = Clock::now();
+      texture.loadFromFile(path, modes[i % 2]);
+      glFinish();
+      results[i % 2] = milliseconds(Clock::now() - start);
+    }
+    return {results[0], results[1]};
+  }
+
+  struct UniformTimings
+  {
+    double string;
+    double id;
+    double handle;
+  };
+
+  // Nanoseconds per uniform update when naming it by string (a std::string
+  // key and two map lookups, the old setUniform), by UniformId and by
+  // UniformHandle. glUniform1i is about the cheapest call there is, so the
+  // lookup dominates.
+  UniformTimings measureUniforms(const Core::GL::GLShader &shader)
+  {
+    constexpr int calls = 1 << 20;
+    shader.use();
+
+    std::unordered_map<std::string, GLint> cache;
+    for (const auto &uniform : shader.getUniforms())
+    {
+      cache[uniform.name] = uniform.location;
+    }
+    auto timeCalls = [](auto &&setUniform)
+    {
+      glFinish();
+      auto start = Clock::now();
+      for (int i = 0; i < calls; ++i)
+      {
+        setUniform(i & 7);
+      }
+      glFinish();
+      return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / calls;
+    };
+
+    UniformTimings timings{};
+    timings.string = timeCalls([&](int value)
+                               {
+                                 const char *name = "u_texture";
+                                 std::string key = name;
+                                 GLint location = cache.contains(key) ? cache[key] : glGetUniformLocation(shader.getID(), name);
+                                 glUniform1i(location, value); });
+    timings.id = timeCalls([&](int value)
+                           { shader.setUniform("u_texture", value); });
+    auto handle = shader.getHandle("u_texture");
+    timings.handle = timeCalls([&](int value)
+                               { shader.setUniform(handle, value); });
+    glUniform1i(shader.getLocation(handle), 0);
+    return timings;
+  }
+
+  struct Base64Throughput
+  {
+    double scalar;
+    double vector;
+  };
+
+  // Decoding rate in MB of base64 text per second for 64 MiB of random
+  // data, best of three, through the table lookup path and decodeBase64
+  Base64Throughput measureBase64()
+  {
+    constexpr std::string_view alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::mt19937 random(1);
+    std::string text(64 << 20, 'A');
+    for (char &c : text)
+    {
+      c = alphabet[random() & 63];
+    }
+    std::vector<std::byte> out(*Core::base64DecodedSize(text));
+
+    auto rate = [&](auto &&decode)
+    {
+      double best = 0.0;
+      for (int round = 0; round < 3; ++round)
+      {
+        auto start = Clock::now();
+        if (!decode(text, std::span(out)))
+        {
+          return 0.0;
+        }
+        best = std::max(best, text.size() / 1e3 / milliseconds(Clock::now() - start));
+      }
+      return best;
+    };
+    return {rate(Core::decodeBase64Scalar), rate(Core::decodeBase64)};
+  }
+
+  // Checks decodeBase64 against the table lookup path on random text, padded
+  // or not, and on copies with characters replaced by arbitrary bytes,
+  // inserted or removed. Both must agree on success and on every output
+  // byte, for the exact output size and for a buffer one byte short.
+  // Returns the number of mismatches.
+  size_t fuzzBase64(size_t cases)
+  {
+    constexpr std::string_view alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::mt19937 random(1);
+    auto below = [&](size_t bound)
+    {
+      return static_cast<size_t>(random() % bound);
+    };
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < cases; ++i)
+    {
+      std::string text(below(200), 'A');
+      for (char &c : text)
+      {
+        c = alphabet[below(64)];
+      }
+      if (below(2))
+      {
+        text.append((4 - text.size() % 4) % 4, '=');
+      }
+      for (size_t mutations = below(4); mutations > 0 && !text.empty(); --mutations)
+      {
+        size_t at = below(text.size());
+        switch (below(3))
+        {
+        case 0:
+          text[at] = static_cast<char>(below(256));
+          break;
+        case 1:
+          text.insert(at, 1, static_cast<char>(below(256)));
+          break;
+        default:
+          text.erase(at, 1);
+          break;
+        }
+      }
+
+      size_t size = Core::base64DecodedSize(text).value_or(0);
+      for (size_t outSize : {size, size - (size != 0)})
+      {
+        std::vector<std::byte> expected(outSize), actual(outSize);
+        bool expectedOk = Core::decodeBase64Scalar(text, expected);
+        bool actualOk = Core::decodeBase64(text, actual);
+        if (expectedOk != actualOk || (expectedOk && expected != actual))
+        {
+          std::cerr << "Base64 mismatch for " << quoted(text) << " into " << outSize << " bytes" << std::endl;
+          ++mismatches;
+        }
+      }
+    }
+    return mismatches;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  auto options = parseOptions(argc, argv);
+  if (!options)
+  {
+    std::cerr << "Usage: viewer-bench [--frames N] [--warmup N] [--width W] [--height H] [--indirect] [--texture image] [--uniforms] [--base64] [--output file.json] scene.glb" << std::endl
+              << "       viewer-bench --base64-fuzz" << std::endl;
+    return -1;
+  }
+  if (options->base64Fuzz)
+  {
+    constexpr size_t cases = 1 << 20;
+    size_t mismatches = fuzzBase64(cases);
+    std::cout << "Base64 fuzz: " << mismatches << " mismatches in " << cases << " cases" << std::endl;
+    return mismatches == 0 ? 0 : 1;
+  }
+
+  Core::Window window(options->width, options->height, "viewer-bench", Core::WindowBackend::Headless);
+  if (!window.isOpen())
+  {
+    return -1;
+  }
+  auto &state = Core::GL::GLState::current();
+
+  auto loadStart = Clock::now();
+  Core::GLTF::Document document;
+  if (auto error = document.loadFromFile(options->scenePath); error)
+  {
+    std::cerr << "glTF Error: " << *error << std::endl;
+    return -1;
+  }
+  std::optional<Core::GLTF::Model> model;
+  std::optional<Core::GLTF::StaticBatch> batch;
+  Core::VertexCacheStatistics cacheBefore;
+  Core::VertexCacheStatistics cacheAfter;
+  std::optional<std::string> error;
+  if (options->indirect)
+  {
+    Core::GLTF::StaticBatch::DecodedGeometry geometry;
+    error = Core::GLTF::StaticBatch::decode(document, geometry);
+    error = error ? error : batch.emplace().build(geometry.view());
+    cacheBefore = geometry.cacheBefore;
+    cacheAfter = geometry.cacheAfter;
+  }
+  else
+  {
+    error = model.emplace().upload(document);
+    cacheBefore = model->getCacheBefore();
+    cacheAfter = model->getCacheAfter();
+  }
+  if (error)
+  {
+    std::cerr << "glTF Upload Error: " << *error << std::endl;
+    return -1;
+  }
+  glFinish();
+  double loadMs = milliseconds(Clock::now() - loadStart);
+  uint64_t loadBytes = state.getStatistics().bytesUploaded;
+
+  Core::GL::GLShader shader(options->indirect ? "assets/shaders/indirect/vertex.glsl" : "assets/shaders/basic/vertex.glsl",
+                            options->indirect ? "assets/shaders/indirect/fragment.glsl" : "assets/shaders/basic/fragment.glsl");
+  Core::GL::GLTexture texture;
+  texture.setSolidColor(255, 255, 255);
+  shader.use();
+  shader.setUniform("u_texture", 0);
+
+  Core::GL::RenderQueue renderQueue;
+  std::vector<double> cpuTimes;
+  std::vector<double> frameTimes;
+  cpuTimes.reserve(options->frames);
+  frameTimes.reserve(options->frames);
+  uint64_t drawCalls = 0;
+
+  for (int frame = 0; frame < options->warmup + options->frames; ++frame)
+  {
+    if (frame == options->warmup)
+    {
+      state.resetStatistics();
+      drawCalls = 0;
+    }
+
+    auto start = Clock::now();
+    glClearColor(0.82, 0.0, 0.07, 1.0);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    shader.use();
+    texture.bind(0);
+    if (batch)
+    {
+      batch->draw();
+      drawCalls += batch->getDrawCallCount();
+    }
+    else
+    {
+      Core::GL::DrawPacket packet;
+      packet.program = shader.getID();
+      packet.texture = texture.getId();
+      packet.objectBlock = true;
+      model->enqueue(renderQueue, packet);
+      renderQueue.flush();
+      drawCalls += renderQueue.getStatistics().packets;
+    }
+    window.swapBuffers();
+    auto submitted = Clock::now();
+
+    // Software rasterizers do their work here, include it in the frame
+    glFinish();
+    auto finished = Clock::now();
+
+    if (frame >= options->warmup)
+    {
+      cpuTimes.push_back(milliseconds(submitted - start));
+      frameTimes.push_back(milliseconds(finished - start));
+    }
+  }
+
+  const auto &statistics = state.getStatistics();
+  std::ostringstream json;
+  json << "{\n"
+       << "  \"scene\": " << quoted(options->scenePath) << ",\n"
+       << "  \"renderer\": " << quoted(reinterpret_cast<const char *>(glGetString(GL_RENDERER))) << ",\n"
+       << "  \"path\": \"" << (options->indirect ? "indirect" : "queue") << "\",\n"
+       << "  \"frames\": " << options->frames << ",\n"
+       << "  \"loadMs\": " << loadMs << ",\n"
+       << "  \"loadBytesUploaded\": " << loadBytes << ",\n"
+       << "  \"cpuFrameMs\": ";
+  writeTimings(json, cpuTimes);
+  json << ",\n  \"frameMs\": ";
+  writeTimings(json, frameTimes);
+  json << ",\n  \"drawCallsPerFrame\": " << drawCalls / options->frames << ",\n"
+       << "  \"stateChanges\": {";
+  writeCounters(json, "programs", statistics.programs);
+  json << ", ";
+  writeCounters(json, "vertexArrays", statistics.vertexArrays);
+  json << ", ";
+  writeCounters(json, "buffers", statistics.buffers);
+  json << ", ";
+  writeCounters(json, "textures", statistics.textures);
+  json << "},\n"
+       << "  \"bytesUploaded\": " << statistics.bytesUploaded << ",\n";
+  if (!options->texturePath.empty())
+  {
+    auto [driverMs, cpuMs] = measureMipmaps(options->texturePath);
+    json << "  \"mipmapMs\": {\"driver\": " << driverMs << ", \"cpu\": " << cpuMs << "},\n";
+  }
+  if (options->uniforms)
+  {
+    auto timings = measureUniforms(shader);
+    json << "  \"uniformNsPerCall\": {\"string\": " << timings.string << ", \"id\": " << timings.id << ", \"handle\": " << timings.handle << "},\n";
+  }
+  if (options->base64)
+  {
+    auto throughput = measureBase64();
+    json << "  \"base64MBps\": {\"scalar\": " << throughput.scalar << ", \"vector\": " << throughput.vector << "},\n";
+  }
+  json << "  \"vertexCache\": {\"acmrBefore\": " << cacheBefore.getACMR() << ", \"acmrAfter\": " << cacheAfter.getACMR()
+       << ", \"atvrBefore\": " << cacheBefore.getATVR() << ", \"atvrAfter\": " << cacheAfter.getATVR() << "},\n";
+  json << "  \"peakRssBytes\": " << peakResidentBytes() << "\n"
+       << "}\n";
+
+  if (options->outputPath.empty())
+  {
+    std::cout << json.str();
+  }
+  else
+  {
+    std::ofstream file(options->outputPath);
+    file << json.str();
+    if (!file)
+    {
+      std::cerr << "Failed to write " << options->outputPath << std::endl;
+      return -1;
+    }
+  }
+
+  return 0;
+}